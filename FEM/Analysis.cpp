@@ -107,7 +107,9 @@ void Analysis::assembleStiffness()
 
         // Bootstrap the computation of local stiffness matrix and force vector. After calling this function, the member variables are all computed
         // @BUG (solved) previous this bootstrap step is in the ctor of derived class ElementQ8, so in the nonlinear analysis, the localStiffness and body & temp force are only computed once at the beginning!
-        curr->computeStiffnessAndForce();
+        // Elements whose moduli and loads have not changed keep their cached results
+        if (staleElement.empty() || staleElement[i])
+            curr->computeStiffnessAndForce();
         // if (i == 0)
         //     std::cout << "local stiff: " << curr->localStiffness() << std::endl;
         const MatrixXd & localStiffness = curr->localStiffness();
@@ -332,6 +334,8 @@ void Analysis::computeStrainAndStress()
                 strainAtGaussPt.row(g) = e.transpose();
                 VectorXd modulus = (curr->modulusAtGaussPt).row(g); // for nonlinear, this is the stabilized modulus at the Gaussian point; for linear elastic, it's just the constant modulus M
                 stressAtGaussPt.row(g) = (curr->EMatrix(modulus) * (e - curr->thermalStrain())).transpose(); // subtract thermal strain, stress = E * (strain - thermal strain)
+                if (!initialStress.empty() && initialStress[i].size() > 0)
+                    stressAtGaussPt.row(g) -= initialStress[i].col(g).transpose(); // tension removed by the no-tension scheme
                 shapeAtGaussPt.row(g) = curr->shape()->functionVec(g).transpose();
             }
 
@@ -151,6 +151,12 @@ class Analysis
 
         /** The nodal shear/normal stress n-by-2 matrix (for I6 element) */
         MatrixXd nodalInterfaceStress;
+
+        /** Whether each element's local stiffness and force must be recomputed at the next assembly, empty to recompute all */
+        std::vector<bool> staleElement;
+
+        /** The initial (removed tension) stress 4-by-g matrix at the Gaussian points of each no-tension element, subtracted from the elastic stress; empty if not used */
+        std::vector<MatrixXd> initialStress;
 };
 
 #endif /* Analysis_h */
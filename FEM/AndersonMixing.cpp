@@ -0,0 +1,87 @@
+/**
+ * @file AndersonMixing.cpp
+ * Implementation of AndersonMixing class.
+ */
+
+#include "AndersonMixing.h"
+
+AndersonMixing::AndersonMixing(const int & depth)
+  : depth_(depth > 0 ? depth : 0), stored_(0), oldest_(0), mixedSteps_(0), fallbackSteps_(0)
+{
+}
+
+AndersonMixing::~AndersonMixing()
+{
+}
+
+void AndersonMixing::reset()
+{
+    stored_ = 0;
+    oldest_ = 0;
+    mixedSteps_ = 0;
+    fallbackSteps_ = 0;
+    xPrev_.resize(0);
+    fPrev_.resize(0);
+}
+
+VectorXd AndersonMixing::update(const VectorXd & x, const VectorXd & g, const double & damping)
+{
+    VectorXd f = g - x;
+    VectorXd plain = x + damping * f;
+    if (depth_ == 0)
+        return plain;
+    if (dX_.rows() != x.size()) {
+        dX_.resize(x.size(), depth_);
+        dF_.resize(x.size(), depth_);
+        reset();
+    }
+
+    bool fallback = false;
+    if (xPrev_.size() == x.size()) {
+        if (f.squaredNorm() > fPrev_.squaredNorm()) {
+            // The residual grows, restart the history from this iterate
+            stored_ = 0;
+            oldest_ = 0;
+            fallback = true;
+        }
+        else {
+            // Ring buffer of the last depth_ differences
+            int col;
+            if (stored_ < depth_)
+                col = stored_++;
+            else {
+                col = oldest_;
+                oldest_ = (oldest_ + 1) % depth_;
+            }
+            dX_.col(col) = x - xPrev_;
+            dF_.col(col) = f - fPrev_;
+        }
+    }
+    xPrev_ = x;
+    fPrev_ = f;
+
+    if (stored_ > 0) {
+        VectorXd gamma = dF_.leftCols(stored_).colPivHouseholderQr().solve(f);
+        VectorXd mixed = plain - (dX_.leftCols(stored_) + damping * dF_.leftCols(stored_)) * gamma;
+        if (mixed.allFinite() && (mixed.array() > 0).all()) {
+            mixedSteps_++;
+            return mixed;
+        }
+        stored_ = 0;
+        oldest_ = 0;
+        fallback = true;
+    }
+    if (fallback)
+        fallbackSteps_++;
+    return plain;
+}
+
+const int & AndersonMixing::mixedSteps() const
+{
+    return mixedSteps_;
+}
+
+const int & AndersonMixing::fallbackSteps() const
+{
+    return fallbackSteps_;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file AndersonMixing.h
+ * Anderson acceleration of the modulus fixed-point iteration.
+ */
+
+#ifndef AndersonMixing_h
+#define AndersonMixing_h
+
+#include "Eigen/Eigen"
+
+using namespace Eigen;
+
+/* Anderson mixing for a fixed-point iteration x = G(x).
+ *
+ * The nonlinear scheme is a damped Picard iteration on the Gauss-point modulus
+ * field: x_(k+1) = x_k + beta * f_k, where f_k = G(x_k) - x_k is the difference
+ * between the stress-dependent modulus and the current modulus. Anderson mixing
+ * (Walker & Ni 2011) keeps the differences of the last m iterates and residuals
+ * in column buffers dX, dF, finds the combination gamma that minimizes
+ * ||f_k - dF gamma|| in the least-squares sense, and takes
+ *
+ *   x_(k+1) = x_k + beta * f_k - (dX + beta * dF) gamma.
+ *
+ * Safeguards: if the residual norm grows, or the mixed step would make any
+ * modulus non-positive, the history is discarded and the plain damped step is
+ * taken instead.
+ */
+class AndersonMixing
+{
+  public:
+    /**
+     * Custom constructor.
+     *
+     * @param depth The number of previous iterates mixed (m), 0 for plain damping.
+     */
+    AndersonMixing(const int & depth);
+
+    ~AndersonMixing();
+
+    /**
+     * Discard the history and the step counts, e.g. when the load changes.
+     */
+    void reset();
+
+    /**
+     * Compute the next iterate.
+     *
+     * @param x The current iterate x_k.
+     * @param g The fixed-point map at the current iterate G(x_k).
+     * @param damping The damping ratio beta.
+     * @return The next iterate x_(k+1).
+     */
+    VectorXd update(const VectorXd & x, const VectorXd & g, const double & damping);
+
+    /**
+     * Get the number of mixed steps taken since the last reset.
+     *
+     * @return The mixed step count.
+     */
+    const int & mixedSteps() const;
+
+    /**
+     * Get the number of plain damped steps taken by the safeguards since the last reset.
+     *
+     * @return The fallback step count.
+     */
+    const int & fallbackSteps() const;
+
+  private:
+    /** Maximum number of stored differences */
+    int depth_;
+
+    /** Number of stored differences, and the column of the oldest one */
+    int stored_, oldest_;
+
+    /** Difference buffers, one column per previous iteration */
+    MatrixXd dX_, dF_;
+
+    /** The previous iterate and residual */
+    VectorXd xPrev_, fPrev_;
+
+    /** Statistics */
+    int mixedSteps_;
+    int fallbackSteps_;
+};
+
+#endif /* AndersonMixing_h */
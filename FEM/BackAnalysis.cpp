@@ -11,7 +11,7 @@
 #include "BackAnalysis.h"
 #include "Linear.h"
 
-BackAnalysis::BackAnalysis(Mesh & meshInfo) : Analysis(meshInfo)
+BackAnalysis::BackAnalysis(Mesh & meshInfo) : Analysis(meshInfo), stiffnessSolver(meshInfo)
 {
 }
 
@@ -48,9 +48,9 @@ void BackAnalysis::solve()
         applyForce();
         assembleStiffness();
 
-        SimplicialLDLT <SparseMatrix<double> > solver;
-        solver.compute(globalStiffness);
-        nodalDisp = solver.solve(nodalForce);
+        stiffnessSolver.solve(globalStiffness, nodalForce, nodalDisp);
+        if (stiffnessSolver.mode() != StiffnessSolver::DEFLATED_CG && stiffnessSolver.skyline())
+            std::cout << "Factor recomputed = " << 100 * stiffnessSolver.recomputedFraction() << "%" << std::endl;
 
         // Check convergence
         match = true;
@@ -10,6 +10,7 @@
 #define BackAnalysis_h
 
 #include "Analysis.h"
+#include "StiffnessSolver.h"
 
 /* Derived class for solving back analysis problems.
  */
@@ -22,6 +23,9 @@ class BackAnalysis : public Analysis
     ~BackAnalysis();
     void solve();
 
+  private:
+    /** Solver for K U = F, keeps the factorization between modulus adjustments */
+    StiffnessSolver stiffnessSolver;
 };
 
 #endif /* BackAnalysis_h */
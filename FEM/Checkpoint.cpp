@@ -0,0 +1,164 @@
+/**
+ * @file Checkpoint.cpp
+ * Implementation of Checkpoint class.
+ */
+
+#include "Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char tag[8] = {'F', 'E', 'M', 'C', 'K', 'P', 'T', '2'};
+
+template <typename T>
+static void writeValue(std::ofstream & out, const T & value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(std::ifstream & in, T & value)
+{
+    return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+Checkpoint::Checkpoint(Mesh & mesh)
+  : mesh_(mesh), hash_(mesh.fingerprint()), loadHash_(mesh.loadFingerprint()), traffic_(false), factor_(0), increment_(0), step_(0), damping_(-1), err_(&std::cerr)
+{
+}
+
+Checkpoint::~Checkpoint()
+{
+}
+
+void Checkpoint::setStream(std::ostream & err)
+{
+    err_ = &err;
+}
+
+bool Checkpoint::save(std::string const & fileName, const bool & traffic, const double & factor, const int & increment, const double & step, const double & damping, const VectorXd & nodalDisp) const
+{
+    std::string tempName = fileName + ".tmp";
+    std::ofstream out(tempName.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        *err_ << "WARNING: Cannot write checkpoint file " << tempName << "." << std::endl;
+        return false;
+    }
+    out.write(tag, sizeof(tag));
+    writeValue(out, hash_);
+    writeValue(out, loadHash_);
+    writeValue(out, (std::int32_t)traffic);
+    writeValue(out, factor);
+    writeValue(out, (std::int32_t)increment);
+    writeValue(out, step);
+    writeValue(out, damping);
+
+    // Increment counts and damping ratios of the input file
+    writeValue(out, (std::int32_t)mesh_.iterations.size());
+    for (auto & v : mesh_.iterations)
+        writeValue(out, v);
+
+    writeValue(out, (std::int64_t)nodalDisp.size());
+    out.write(reinterpret_cast<const char*>(nodalDisp.data()), nodalDisp.size() * sizeof(double));
+    for (int i = 0; i < mesh_.elementCount(); i++) {
+        const MatrixXd & modulus = mesh_.elementArray()[i]->modulusAtGaussPt;
+        writeValue(out, (std::int32_t)modulus.rows());
+        writeValue(out, (std::int32_t)modulus.cols());
+        out.write(reinterpret_cast<const char*>(modulus.data()), modulus.size() * sizeof(double));
+    }
+    out.close();
+    if (!out || std::rename(tempName.c_str(), fileName.c_str()) != 0) {
+        *err_ << "WARNING: Cannot write checkpoint file " << fileName << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::load(std::string const & fileName)
+{
+    std::ifstream in(fileName.c_str(), std::ios::binary);
+    if (!in) {
+        *err_ << "WARNING: Checkpoint file " << fileName << " not found, start from the beginning." << std::endl;
+        return false;
+    }
+    char fileTag[sizeof(tag)];
+    std::uint64_t hash, loadHash;
+    if (!in.read(fileTag, sizeof(fileTag)) || std::memcmp(fileTag, tag, sizeof(tag)) != 0 || !readValue(in, hash) || !readValue(in, loadHash)) {
+        *err_ << "WARNING: " << fileName << " is not a checkpoint file, start from the beginning." << std::endl;
+        return false;
+    }
+    if (hash != hash_) {
+        *err_ << "WARNING: Checkpoint file " << fileName << " belongs to a different mesh, start from the beginning." << std::endl;
+        return false;
+    }
+    if (loadHash != loadHash_) {
+        *err_ << "WARNING: Checkpoint file " << fileName << " was written with different material parameters or loads, start from the beginning." << std::endl;
+        return false;
+    }
+
+    std::int32_t traffic, increment, iterationCount;
+    bool ok = readValue(in, traffic) && readValue(in, factor_) && readValue(in, increment) && readValue(in, step_) && readValue(in, damping_) && readValue(in, iterationCount);
+    std::vector<double> iterations(ok && iterationCount > 0 ? iterationCount : 0);
+    for (auto & v : iterations)
+        ok = ok && readValue(in, v);
+    if (ok && iterations != mesh_.iterations)
+        *err_ << "WARNING: The increment settings differ from those of the checkpoint, the checkpoint increments are resumed with the new settings." << std::endl;
+
+    std::int64_t dispSize;
+    ok = ok && readValue(in, dispSize) && dispSize == 2 * mesh_.nodeCount();
+    if (ok) {
+        disp_.resize(dispSize);
+        ok = (bool)in.read(reinterpret_cast<char*>(disp_.data()), dispSize * sizeof(double));
+    }
+    modulus_.clear();
+    for (int i = 0; ok && i < mesh_.elementCount(); i++) {
+        const MatrixXd & current = mesh_.elementArray()[i]->modulusAtGaussPt;
+        std::int32_t rows, cols;
+        ok = readValue(in, rows) && readValue(in, cols) && rows == current.rows() && cols == current.cols();
+        if (ok) {
+            modulus_.push_back(MatrixXd(rows, cols));
+            ok = (bool)in.read(reinterpret_cast<char*>(modulus_.back().data()), modulus_.back().size() * sizeof(double));
+        }
+    }
+    if (!ok) {
+        *err_ << "WARNING: Checkpoint file " << fileName << " is truncated or inconsistent with the mesh, start from the beginning." << std::endl;
+        modulus_.clear();
+        return false;
+    }
+    traffic_ = traffic != 0;
+    increment_ = increment;
+    return true;
+}
+
+void Checkpoint::restore(VectorXd & nodalDisp) const
+{
+    for (int i = 0; i < (int)modulus_.size(); i++)
+        mesh_.elementArray()[i]->modulusAtGaussPt = modulus_[i];
+    nodalDisp = disp_;
+}
+
+const bool & Checkpoint::traffic() const
+{
+    return traffic_;
+}
+
+const double & Checkpoint::factor() const
+{
+    return factor_;
+}
+
+const int & Checkpoint::increment() const
+{
+    return increment_;
+}
+
+const double & Checkpoint::step() const
+{
+    return step_;
+}
+
+const double & Checkpoint::damping() const
+{
+    return damping_;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file Checkpoint.h
+ * Binary checkpoint and restart of the incremental nonlinear scheme.
+ */
+
+#ifndef Checkpoint_h
+#define Checkpoint_h
+
+#include "Mesh.h"
+#include "Eigen/Eigen"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Eigen;
+
+/* State of the incremental scheme after a converged increment: the stage,
+ * the load factor and step, the adapted damping ratio, the increment counts
+ * and damping ratios of the input file, the nodal displacement and the
+ * Gauss-point moduli of all elements.
+ *
+ * The file is raw binary in the byte order of the machine that wrote it,
+ * starting with a format tag, the fingerprint of the mesh and the fingerprint
+ * of the material parameters and loads (see Mesh::fingerprint() and
+ * Mesh::loadFingerprint()). A file of another mesh or another problem on it,
+ * or with moduli of other sizes, is rejected. The file is written to a temporary name and renamed,
+ * so a crash during the write keeps the previous checkpoint.
+ */
+class Checkpoint
+{
+  public:
+    /**
+     * Custom constructor.
+     *
+     * @param mesh The mesh whose state is saved and restored.
+     */
+    explicit Checkpoint(Mesh & mesh);
+
+    ~Checkpoint();
+
+    /**
+     * Set the stream of the warnings, std::cerr by default.
+     *
+     * @param err The stream.
+     */
+    void setStream(std::ostream & err);
+
+    /**
+     * Write the current state.
+     *
+     * @param fileName The checkpoint file.
+     * @param traffic True for the traffic stage, false for the body force stage.
+     * @param factor The converged load factor of the stage.
+     * @param increment The number of converged increments of the stage.
+     * @param step The load factor increment of adaptive stepping.
+     * @param damping The adapted damping ratio.
+     * @param nodalDisp The nodal displacement.
+     * @return Whether the file was written.
+     */
+    bool save(std::string const & fileName, const bool & traffic, const double & factor, const int & increment, const double & step, const double & damping, const VectorXd & nodalDisp) const;
+
+    /**
+     * Read a checkpoint written for this mesh. The moduli and displacement
+     * are kept until restore().
+     *
+     * @param fileName The checkpoint file.
+     * @return Whether the file was read and matches the mesh.
+     */
+    bool load(std::string const & fileName);
+
+    /**
+     * Put the loaded moduli into the elements and return the displacement.
+     *
+     * @param nodalDisp The nodal displacement.
+     */
+    void restore(VectorXd & nodalDisp) const;
+
+    /** Accessors of the loaded state */
+    const bool & traffic() const;
+    const double & factor() const;
+    const int & increment() const;
+    const double & step() const;
+    const double & damping() const;
+
+  private:
+    /** The mesh */
+    Mesh & mesh_;
+
+    /** Fingerprints of the mesh and of the material parameters and loads */
+    std::uint64_t hash_, loadHash_;
+
+    /** Loaded state */
+    bool traffic_;
+    double factor_;
+    int increment_;
+    double step_;
+    double damping_;
+    VectorXd disp_;
+    std::vector<MatrixXd> modulus_;
+
+    /** The stream of the warnings */
+    std::ostream* err_;
+};
+
+#endif /* Checkpoint_h */
@@ -0,0 +1,91 @@
+/**
+ * @file ConstitutiveBatch.cpp
+ * Implementation of ConstitutiveBatch class.
+ */
+
+#include "ConstitutiveBatch.h"
+#include <algorithm>
+
+ConstitutiveBatch::ConstitutiveBatch()
+{
+}
+
+ConstitutiveBatch::~ConstitutiveBatch()
+{
+}
+
+void ConstitutiveBatch::resize(const int & n)
+{
+    sr_.resize(n);
+    st_.resize(n);
+    sz_.resize(n);
+    trz_.resize(n);
+    sigma3_.resize(n);
+    sigma2_.resize(n);
+    sigma1_.resize(n);
+    Mr_.resize(n);
+    Mz_.resize(n);
+    G_.resize(n);
+    material_.resize(n);
+}
+
+void ConstitutiveBatch::set(const int & k, Material* material, const VectorXd & stress)
+{
+    sr_[k] = stress(0);
+    st_[k] = stress(1);
+    sz_[k] = stress(2);
+    trz_[k] = stress(3);
+    material_[k] = material;
+}
+
+int ConstitutiveBatch::size() const
+{
+    return (int)sr_.size();
+}
+
+void ConstitutiveBatch::evaluate(const int & begin, const int & end)
+{
+    for (int k = begin; k < end; k++)
+        principalStress(sr_[k], st_[k], sz_[k], trz_[k], sigma3_[k], sigma2_[k], sigma1_[k]);
+
+    // One call per run of consecutive points of the same material (long runs
+    // when the elements of a layer are numbered together). The points of a
+    // run are already contiguous, so no gather is needed
+    int first = begin;
+    while (first < end) {
+        int last = first + 1;
+        while (last < end && material_[last] == material_[first])
+            last++;
+        material_[first]->stressDependentModulus(last - first, &sigma3_[first], &sigma2_[first], &sigma1_[first], &Mr_[first], &Mz_[first], &G_[first]);
+        first = last;
+    }
+}
+
+double ConstitutiveBatch::modulus(const int & k, const int & c) const
+{
+    return c == 0 ? Mr_[k] : (c == 1 ? Mz_[k] : G_[k]);
+}
+
+void ConstitutiveBatch::tension(const int & begin, const int & end)
+{
+    // Principal stresses in the r-z plane, p1,3 = (s_r + s_z) / 2 +- radius, p2 = s_theta, and
+    // the rotation cos(2 theta) = (s_r - s_z) / (2 radius), sin(2 theta) = tau_rz / radius.
+    // No sorting is needed, so the loop is branch free
+    for (int k = begin; k < end; k++) {
+        double radius = std::sqrt((sr_[k] - sz_[k]) * (sr_[k] - sz_[k]) / 4 + trz_[k] * trz_[k]);
+        double center = (sr_[k] + sz_[k]) / 2;
+        double cos2 = radius > 0 ? (sr_[k] - sz_[k]) / (2 * radius) : 1;
+        double sin2 = radius > 0 ? trz_[k] / radius : 0;
+        double t1 = std::max(center + radius, 0.0);
+        double t3 = std::max(center - radius, 0.0);
+        sr_[k] = (t1 + t3) / 2 + (t1 - t3) * cos2 / 2;
+        st_[k] = std::max(st_[k], 0.0);
+        sz_[k] = (t1 + t3) / 2 - (t1 - t3) * cos2 / 2;
+        trz_[k] = (t1 - t3) * sin2 / 2;
+    }
+}
+
+double ConstitutiveBatch::stress(const int & k, const int & c) const
+{
+    return c == 0 ? sr_[k] : (c == 1 ? st_[k] : (c == 2 ? sz_[k] : trz_[k]));
+}
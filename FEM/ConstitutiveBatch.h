@@ -0,0 +1,132 @@
+/**
+ * @file ConstitutiveBatch.h
+ * Batched constitutive update of the Gauss points of nonlinear elements.
+ */
+
+#ifndef ConstitutiveBatch_h
+#define ConstitutiveBatch_h
+
+#include "Eigen/Eigen"
+#include "Material.h"
+#include <vector>
+#include <cmath>
+
+using namespace Eigen;
+
+/* Structure-of-arrays store of the Gauss-point stresses and moduli.
+ *
+ * The nonlinear scheme first sets the stress of every Gauss point, then
+ * evaluate() computes the principal stresses of a range in one pass and the
+ * stress-dependent moduli in one call per material, each over contiguous
+ * arrays so that the arithmetic runs in SIMD lanes.
+ *
+ * For the axisymmetric stress state (sigma_r, sigma_theta, sigma_z, tau_rz)
+ * the stress tensor is block diagonal: sigma_theta is a principal stress and
+ * the other two are the eigenvalues of the 2x2 block in the r-z plane,
+ *
+ *   (sigma_r + sigma_z) / 2 +- sqrt(((sigma_r - sigma_z) / 2)^2 + tau_rz^2),
+ *
+ * so no eigensolver is needed.
+ */
+class ConstitutiveBatch
+{
+  public:
+    ConstitutiveBatch();
+    ~ConstitutiveBatch();
+
+    /**
+     * Set the number of Gauss points, keeping the allocated storage.
+     *
+     * @param n The batch size.
+     */
+    void resize(const int & n);
+
+    /**
+     * Set the stress of a Gauss point. Different points can be set concurrently.
+     *
+     * @param k The index of the Gauss point in the batch.
+     * @param material The material of the element.
+     * @param stress Stresses in cylindrical coordinates, sigma_r, sigma_theta, sigma_z, tau_rz.
+     */
+    void set(const int & k, Material* material, const VectorXd & stress);
+
+    /**
+     * Get the number of Gauss points.
+     *
+     * @return The batch size.
+     */
+    int size() const;
+
+    /**
+     * Compute the principal stresses and the stress-dependent moduli of the
+     * Gauss points in [begin, end). Disjoint ranges can be evaluated concurrently.
+     *
+     * @param begin The first Gauss point.
+     * @param end One past the last Gauss point.
+     */
+    void evaluate(const int & begin, const int & end);
+
+    /**
+     * Get a stress-dependent modulus computed by evaluate().
+     *
+     * @param k The index of the Gauss point.
+     * @param c 0 for horizontal, 1 for vertical, 2 for shear modulus.
+     * @return The modulus.
+     */
+    double modulus(const int & k, const int & c) const;
+
+    /**
+     * Replace the stresses of the Gauss points in [begin, end) by their
+     * tensile parts: the principal stresses are clamped at zero from above
+     * (+ is tension) and rotated back to cylindrical coordinates. Disjoint
+     * ranges can be computed concurrently.
+     *
+     * @param begin The first Gauss point.
+     * @param end One past the last Gauss point.
+     */
+    void tension(const int & begin, const int & end);
+
+    /**
+     * Get a stress of a Gauss point, as set or as replaced by tension().
+     *
+     * @param k The index of the Gauss point.
+     * @param c 0 for sigma_r, 1 for sigma_theta, 2 for sigma_z, 3 for tau_rz.
+     * @return The stress.
+     */
+    double stress(const int & k, const int & c) const;
+
+    /**
+     * Closed-form principal stresses of an axisymmetric stress state.
+     *
+     * @param sr, st, sz, trz Stresses in cylindrical coordinates.
+     * @param sigma3, sigma2, sigma1 The principal stresses in ascending order.
+     */
+    static void principalStress(const double & sr, const double & st, const double & sz, const double & trz, double & sigma3, double & sigma2, double & sigma1)
+    {
+        double center = (sr + sz) / 2;
+        double radius = std::sqrt((sr - sz) * (sr - sz) / 4 + trz * trz);
+        sigma1 = center + radius;
+        sigma3 = center - radius;
+        sigma2 = st;
+        // sigma_theta may lie anywhere between the in-plane pair
+        if (sigma2 > sigma1)
+            std::swap(sigma1, sigma2);
+        if (sigma2 < sigma3)
+            std::swap(sigma2, sigma3);
+    }
+
+  private:
+    /** Cylindrical stresses of each Gauss point */
+    std::vector<double> sr_, st_, sz_, trz_;
+
+    /** Principal stresses of each Gauss point */
+    std::vector<double> sigma3_, sigma2_, sigma1_;
+
+    /** Stress-dependent horizontal, vertical and shear moduli of each Gauss point */
+    std::vector<double> Mr_, Mz_, G_;
+
+    /** The material of each Gauss point */
+    std::vector<Material*> material_;
+};
+
+#endif /* ConstitutiveBatch_h */
@@ -0,0 +1,168 @@
+/**
+ * @file Creep.cpp
+ * Implementation of Creep class.
+ */
+
+#include "Creep.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+Creep::Creep(Mesh & meshInfo) : Analysis(meshInfo), factorizations(0)
+{
+    timeStep = mesh.setting("time_step", 1);
+    timeSteps = (int)mesh.setting("time_steps", 10);
+    timeGrowth = mesh.setting("time_growth", 1);
+    if (timeStep <= 0 || timeGrowth <= 0) {
+        std::cerr << "WARNING: Time step and time growth must be positive, use 1 instead." << std::endl;
+        timeStep = timeStep > 0 ? timeStep : 1;
+        timeGrowth = timeGrowth > 0 ? timeGrowth : 1;
+    }
+
+    std::istringstream in(mesh.settingString("load_history", ""));
+    double t, f;
+    while (in >> t >> f) {
+        if (!historyTime.empty() && t <= historyTime.back()) {
+            std::cerr << "WARNING: Load history times must increase, the rest of the history is ignored." << std::endl;
+            break;
+        }
+        historyTime.push_back(t);
+        historyFactor.push_back(f);
+    }
+
+    // State of the Gaussian points of the viscoelastic elements, starting from rest
+    viscoMaterial.assign(mesh.elementCount(), NULL);
+    strainState.assign(mesh.elementCount(), MatrixXd());
+    branchState.assign(mesh.elementCount(), std::vector<MatrixXd>());
+    initialStress.assign(mesh.elementCount(), MatrixXd());
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        Element* curr = mesh.elementArray()[i];
+        viscoMaterial[i] = dynamic_cast<ViscoElastic*>(curr->material());
+        if (viscoMaterial[i] == NULL)
+            continue;
+        int numGaussianPt = (int)curr->shape()->gaussianPt().size();
+        strainState[i] = MatrixXd::Zero(4, numGaussianPt);
+        branchState[i].assign(numGaussianPt, MatrixXd::Zero(4, viscoMaterial[i]->terms()));
+        initialStress[i] = MatrixXd::Zero(4, numGaussianPt);
+    }
+
+    fixedDof.assign(2 * mesh.nodeCount(), false);
+    for (auto & dof : mesh.boundaryNodeList)
+        fixedDof[dof] = true;
+}
+
+Creep::~Creep()
+{
+}
+
+void Creep::solve()
+{
+    // Step 0 is the instantaneous response to the loads applied at t = 0
+    double t = 0, dt = 0, lastDt = -1;
+    for (int step = 0; step <= timeSteps; step++) {
+        if (step > 0) {
+            dt = timeStep * std::pow(timeGrowth, step - 1);
+            t += dt;
+        }
+        if (dt != lastDt) {
+            changeTimeStep(dt);
+            lastDt = dt;
+        }
+
+        double factor = loadFactor(t);
+        std::cout << "Time step No." << step << ", t = " << t << ", load factor = " << factor << std::endl;
+        nodalDisp = solver.solve(constantForce + factor * trafficForce + historyForce());
+        updateState();
+    }
+    std::cout << "Factorizations = " << factorizations << " for " << timeSteps + 1 << " time steps" << std::endl;
+
+    // The initial stress still holds -sigma* of the last step, so the stress is the one of the final time
+    computeStrainAndStress();
+    averageStrainAndStress();
+}
+
+double Creep::loadFactor(const double & t) const
+{
+    if (historyTime.empty())
+        return 1;
+    if (t <= historyTime.front())
+        return historyFactor.front();
+    if (t >= historyTime.back())
+        return historyFactor.back();
+    int k = (int)(std::upper_bound(historyTime.begin(), historyTime.end(), t) - historyTime.begin());
+    double ratio = (t - historyTime[k - 1]) / (historyTime[k] - historyTime[k - 1]);
+    return historyFactor[k - 1] + ratio * (historyFactor[k] - historyFactor[k - 1]);
+}
+
+void Creep::changeTimeStep(const double & dt)
+{
+    for (auto & m : mesh.materialList) {
+        ViscoElastic* visco = dynamic_cast<ViscoElastic*>(m);
+        if (visco != NULL)
+            visco->setTimeStep(dt);
+    }
+
+    // Point and edge loads of factor 1, then the body force and thermal load on top
+    applyForce();
+    trafficForce = nodalForce;
+    for (int d = 0; d < (int)trafficForce.size(); d++)
+        if (fixedDof[d])
+            trafficForce(d) = 0;
+    assembleStiffness();
+    constantForce = nodalForce - trafficForce;
+
+    // Only the viscoelastic elements change with the step size after the first assembly
+    staleElement.assign(mesh.elementCount(), false);
+    for (int i = 0; i < mesh.elementCount(); i++)
+        staleElement[i] = viscoMaterial[i] != NULL;
+
+    // The sparsity pattern never changes, so the symbolic analysis is done once
+    if (factorizations == 0)
+        solver.analyzePattern(globalStiffness);
+    solver.factorize(globalStiffness);
+    factorizations++;
+}
+
+VectorXd Creep::historyForce()
+{
+    VectorXd force = VectorXd::Zero(2 * mesh.nodeCount());
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        if (viscoMaterial[i] == NULL)
+            continue;
+        Element* curr = mesh.elementArray()[i];
+        for (int g = 0; g < (int)strainState[i].cols(); g++)
+            initialStress[i].col(g) = -viscoMaterial[i]->historyStress(strainState[i].col(g), branchState[i][g]);
+        VectorXd elementForce = curr->computeTensionForce(initialStress[i]);
+        const VectorXi & nodeList = curr->getNodeList();
+        for (int k = 0; k < (int)nodeList.size(); k++) {
+            force(2 * nodeList(k)) += elementForce(2 * k);
+            force(2 * nodeList(k) + 1) += elementForce(2 * k + 1);
+        }
+    }
+    for (int d = 0; d < (int)force.size(); d++)
+        if (fixedDof[d])
+            force(d) = 0;
+    return force;
+}
+
+void Creep::updateState()
+{
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        if (viscoMaterial[i] == NULL)
+            continue;
+        Element* curr = mesh.elementArray()[i];
+        const VectorXi & nodeList = curr->getNodeList();
+        int numNodes = curr->getSize();
+        VectorXd nodeDisp(2 * numNodes);
+        for (int j = 0; j < numNodes; j++) {
+            nodeDisp(2 * j) = nodalDisp(2 * nodeList(j));
+            nodeDisp(2 * j + 1) = nodalDisp(2 * nodeList(j) + 1);
+        }
+        for (int g = 0; g < (int)strainState[i].cols(); g++) {
+            VectorXd strain = curr->BMatrix(curr->shape()->gaussianPt(g)) * nodeDisp - curr->thermalStrain(); // mechanical strain
+            viscoMaterial[i]->updateHistory(strain - strainState[i].col(g), branchState[i][g]);
+            strainState[i].col(g) = strain;
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ * @file Creep.h
+ * Derived class from Analysis for quasi-static viscoelastic problems.
+ */
+
+#ifndef Creep_h
+#define Creep_h
+
+#include "Analysis.h"
+#include "ViscoElastic.h"
+#include <vector>
+
+/* Derived class for stepping viscoelastic problems through a load history.
+ *
+ * Each step solves K(dt) u = F_body + F_thermal + f(t) F_traffic + int B^T (-sigma*) dV,
+ * where K(dt) uses the effective E matrix of the viscoelastic layers for the
+ * step size dt and sigma* is the history stress of the Prony branches (see
+ * ViscoElastic). Every Gaussian point of a viscoelastic element keeps only its
+ * strain and one stress per branch, updated recursively after each step, so
+ * the memory does not grow with the number of steps. K(dt) only changes with
+ * dt, so it is factorized once per distinct step size and every other step is
+ * a pair of triangular solves.
+ *
+ * Settings:
+ *   time_step   the first step size (1)
+ *   time_steps  the number of steps after the instantaneous response at t = 0 (10)
+ *   time_growth the ratio of each step size to the previous one (1)
+ *   load_history "t0 f0 t1 f1 ..." piecewise linear factor of the point and edge
+ *                loads in time, constant outside the range (constant 1)
+ * The body force and the thermal load are applied at t = 0 and held.
+ */
+class Creep : public Analysis
+{
+  public:
+    /* See the documentation of base class Analysis.
+     */
+    Creep(Mesh & meshInfo);
+    ~Creep();
+    void solve();
+
+  private:
+    /** Time stepping parameters */
+    double timeStep; /* first step size */
+    int timeSteps; /* number of steps after t = 0 */
+    double timeGrowth; /* ratio of successive step sizes */
+
+    /** Load history as (time, factor) points */
+    std::vector<double> historyTime, historyFactor;
+
+    /** The viscoelastic material of each element, NULL if the element is not viscoelastic */
+    std::vector<ViscoElastic*> viscoMaterial;
+
+    /** The mechanical strain 4-by-g matrix at the Gaussian points of each viscoelastic element at the end of the last step */
+    std::vector<MatrixXd> strainState;
+
+    /** The 4-by-terms branch stresses at each Gaussian point of each viscoelastic element */
+    std::vector<std::vector<MatrixXd> > branchState;
+
+    /** Whether each DOF is prescribed */
+    std::vector<bool> fixedDof;
+
+    /** The body force and thermal load (with prescribed values at fixed DOFs) and the point and edge loads of factor 1 */
+    VectorXd constantForce, trafficForce;
+
+    /** The factorized stiffness matrix of the current step size */
+    SimplicialLDLT<SparseMatrix<double> > solver;
+
+    /** The number of factorizations */
+    int factorizations;
+
+    /**
+     * Interpolate the load history.
+     *
+     * @param t The time.
+     * @return The load factor at time t.
+     */
+    double loadFactor(const double & t) const;
+
+    /**
+     * Set the step size of all viscoelastic materials, reassemble the stiffness
+     * matrix and the constant loads, and factorize.
+     *
+     * @param dt The step size.
+     */
+    void changeTimeStep(const double & dt);
+
+    /**
+     * Compute the history stress of the step at each Gaussian point as the
+     * initial stress, and return its nodal force.
+     *
+     * @return The nodal force int B^T (-sigma*) dV, zero at fixed DOFs.
+     */
+    VectorXd historyForce();
+
+    /**
+     * Advance the strain and the branch stresses of each Gaussian point with
+     * the solved displacement.
+     */
+    void updateState();
+};
+
+#endif /* Creep_h */
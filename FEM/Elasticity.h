@@ -0,0 +1,90 @@
+/**
+ * @file Elasticity.h
+ * Fixed-size builders of the stress-dependent constitutive matrix.
+ */
+
+#ifndef Elasticity_h
+#define Elasticity_h
+
+#include "Eigen/Eigen"
+#include "Material.h"
+
+using namespace Eigen;
+
+/* The E matrix of a nonlinear elastic material at a Gaussian point, built on
+ * the stack from the moduli stored in Element::modulusAtGaussPt. The caller
+ * picks the builder once per element (the material is the same at all of its
+ * Gaussian points) and integrates with it as a template parameter, so there is
+ * neither a virtual call nor a heap allocation per point. The arithmetic is
+ * that of NonlinearElastic::EMatrix(), which uses these builders too.
+ */
+
+/** Isotropic E matrix from the single modulus M */
+class IsotropicElasticity
+{
+  public:
+    explicit IsotropicElasticity(const Material & material)
+      : v_(material.poisson())
+    {
+        pattern_ << 1 - v_, v_, v_, 0,
+                    v_, 1 - v_, v_, 0,
+                    v_, v_, 1 - v_, 0,
+                    0, 0, 0, (1 - 2 * v_) / 2;
+    }
+
+    /**
+     * @param modulus The moduli of all Gaussian points (one column).
+     * @param g The Gaussian point.
+     * @param E The constitutive matrix.
+     */
+    void build(const MatrixXd & modulus, const int & g, Matrix4d & E) const
+    {
+        build(modulus(g, 0), E);
+    }
+
+    void build(const double & M, Matrix4d & E) const
+    {
+        E = pattern_ * M / (1 + v_) / (1 - 2 * v_);
+    }
+
+  private:
+    double v_;
+    Matrix4d pattern_;
+};
+
+/** Cross-anisotropic E matrix from the horizontal, vertical & shear moduli */
+class CrossAnisotropicElasticity
+{
+  public:
+    explicit CrossAnisotropicElasticity(const Material & material)
+      : vr_(material.poissonR()), vz_(material.poissonZ())
+    {
+    }
+
+    /**
+     * @param modulus The moduli of all Gaussian points (horizontal, vertical & shear columns).
+     * @param g The Gaussian point.
+     * @param E The constitutive matrix.
+     */
+    void build(const MatrixXd & modulus, const int & g, Matrix4d & E) const
+    {
+        build(modulus(g, 0), modulus(g, 1), modulus(g, 2), E);
+    }
+
+    void build(const double & Mr, const double & Mz, const double & G, Matrix4d & E) const
+    {
+        double n = Mr / Mz;
+        double m = G / Mz;
+        double A = Mz / (1 + vr_) / (1 - vr_ - 2 * n * vz_ * vz_);
+        E << n * (1 - n * vz_ * vz_), n * (vr_ + n * vz_ * vz_), n * vz_ * (1 + vr_), 0,
+             n * (vr_ + n * vz_ * vz_), n * (1 - n * vz_ * vz_), n * vz_ * (1 + vr_), 0,
+             n * vz_ * (1 + vr_), n * vz_ * (1 + vr_), 1 - vr_ * vr_, 0,
+             0, 0, 0, m * (1 + vr_) * (1 - vr_ - 2 * n * vz_ * vz_);
+        E = E * A;
+    }
+
+  private:
+    double vr_, vz_;
+};
+
+#endif /* Elasticity_h */
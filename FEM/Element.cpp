@@ -10,6 +10,7 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include "Element.h"
+#include "Elasticity.h"
 #include <iostream>
 
 Element::Element()
@@ -123,6 +124,13 @@ void Element::computeStiffnessAndForce()
     {   // geosynthetic interface element is different (no integration involved)
         localStiffness_ = BMatrix(Vector2d::Zero()).transpose() * EMatrix(Vector2d::Zero()) * BMatrix(Vector2d::Zero());
     }
+    else if (material_->nonlinearity)
+    {   // stress-dependent E matrix at each Gaussian point, the builder is picked once here
+        if (material_->anisotropy)
+            _integrate(CrossAnisotropicElasticity(*material_));
+        else
+            _integrate(IsotropicElasticity(*material_));
+    }
     else 
     {   // other types of element needs integration to form local stiffness matrix
         for (int i = 0; i < shape()->gaussianPt().size(); i++) {
@@ -144,6 +152,21 @@ void Element::computeStiffnessAndForce()
     }
 }
 
+template <class Elasticity>
+void Element::_integrate(const Elasticity & elasticity)
+{
+    Matrix4d E;
+    for (int i = 0; i < (int)shape()->gaussianPt().size(); i++) {
+        elasticity.build(modulusAtGaussPt, i, E);
+        // Local stiffness matrix
+        localStiffness_ += 2 * M_PI * _BMatrix(i).transpose() * E * _BMatrix(i) * _jacobianDet(i) * _radius(i) * shape()->gaussianWt(i);
+        // Body force
+        nodalForce_ += 2 * M_PI * shape()->functionMat(i).transpose() * bodyForce() * _jacobianDet(i) * _radius(i) * shape()->gaussianWt(i);
+        // Temperature load
+        nodalForce_ += 2 * M_PI * _BMatrix(i).transpose() * E * thermalStrain() * _jacobianDet(i) * _radius(i) * shape()->gaussianWt(i);
+    }
+}
+
 void Element::computerForce()
 {
     nodalForce_ = VectorXd::Zero(2 * size_);
@@ -167,6 +190,14 @@ VectorXd Element::computeTensionForce(const MatrixXd & tension){
     return tensionForce;
 }
 
+MatrixXd Element::computeMass(const double & density){
+    // sum 2PI * rho * N^T * N * |J| * r * W(i) at all Gaussian points
+    MatrixXd mass = MatrixXd::Zero(2 * size_, 2 * size_);
+    for (int i = 0; i < (int)shape()->gaussianPt().size(); i++)
+        mass += 2 * M_PI * density * shape()->functionMat(i).transpose() * shape()->functionMat(i) * _jacobianDet(i) * _radius(i) * shape()->gaussianWt(i);
+    return mass;
+}
+
 const int & Element::getIndex() const
 {
     return index_;
@@ -237,5 +268,6 @@ void Element::copy_(Element const & other)
     material_ = other.material_;
     localStiffness_ = other.localStiffness_;
     nodalForce_ = other.nodalForce_;
+    modulusAtGaussPt = other.modulusAtGaussPt;
 
 }
@@ -86,6 +86,14 @@ class Element
          */
         virtual Shape* shape() const = 0; // return Shape * & is insecure
 
+        /**
+         * Deep copy of the element, including its Gaussian-point moduli and
+         * cached stiffness. The material is shared.
+         *
+         * @return A pointer to the new element, to be deleted by the caller.
+         */
+        virtual Element* clone() const = 0;
+
         /**
          * Get the material information of the element.
          *
@@ -196,6 +204,14 @@ class Element
          */
         VectorXd computeTensionForce(const MatrixXd & tension);
 
+        /**
+         * Helper function for the computation of consistent mass matrix.
+         *
+         * @param density The mass density of the element.
+         * @return The element consistent mass matrix.
+         */
+        MatrixXd computeMass(const double & density);
+
         /**
          * Get the index of this element.
          *
@@ -360,6 +376,17 @@ class Element
          */
         double _radius(const int & i) const;
 
+        /**
+         * Private helper function for integrating the local stiffness matrix and
+         * nodal force of a nonlinear elastic element, with the E matrix of each
+         * Gaussian point built by a fixed-size builder of Elasticity.h chosen once
+         * for the element.
+         *
+         * @param elasticity The E matrix builder of the material.
+         */
+        template <class Elasticity>
+        void _integrate(const Elasticity & elasticity);
+
         /**
          * Private helper function for deleting the current element, used in destructor
          * and assignment operator.
@@ -25,6 +25,11 @@ ElementB3::~ElementB3()
 {
 }
 
+Element* ElementB3::clone() const
+{
+    return new ElementB3(*this);
+}
+
 Shape* ElementB3::shape() const
 {
  return statics.shape;
@@ -22,6 +22,7 @@ class ElementB3 : public Element
      ~ElementB3();
 
      Shape* shape() const;
+     Element* clone() const;
 
      MatrixXd EMatrix(const VectorXd & modulus) const;
      MatrixXd BMatrix(const Vector2d & point) const;
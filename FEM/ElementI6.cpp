@@ -19,6 +19,7 @@ ElementI6::ElementI6(const int & index, const std::vector<int> & nodeList, Node*
  : Element(index, nodeList, meshNode, material) // call the constructor of base class in the initializer list!
 {
     // B matrix never changes, so cache it as a member variable
+    shearFactor_ = Vector3d::Ones(); // bonded
     B_ = MatrixXd::Zero(6, 2 * size_); // 6x12, B matrix
     // from nodal displacements to relative displacements
     
@@ -32,6 +33,11 @@ ElementI6::~ElementI6()
 {
 }
 
+Element* ElementI6::clone() const
+{
+    return new ElementI6(*this);
+}
+
 Shape* ElementI6::shape() const
 {   // not used but a pure virtual method, return empty to suppress error
     return NULL;
@@ -54,11 +60,11 @@ MatrixXd ElementI6::EMatrix(const VectorXd & modulus) const
     double kn = material_->getInterfaceNormalStiffness();
 
     MatrixXd E = MatrixXd::Zero(6, 6); // 6x6
-    E(0,0) = c0 * ks;
+    E(0,0) = c0 * ks * shearFactor_(0);
     E(1,1) = c0 * kn;
-    E(2,2) = c1 * ks;
+    E(2,2) = c1 * ks * shearFactor_(1);
     E(3,3) = c1 * kn;
-    E(4,4) = c2 * ks;
+    E(4,4) = c2 * ks * shearFactor_(2);
     E(5,5) = c2 * kn;
 
     return E;
@@ -76,6 +82,16 @@ MatrixXd ElementI6::_BMatrix(const int & i) const
     return Matrix2d::Zero();
 }
 
+const Vector3d & ElementI6::shearFactor() const
+{
+    return shearFactor_;
+}
+
+void ElementI6::setShearFactor(const int & pair, const double & factor)
+{
+    shearFactor_(pair) = factor;
+}
+
 double ElementI6::_angle() const
 {
     // angle = arctan2(z2-z0/r2-r0) in [-pi, pi], radians
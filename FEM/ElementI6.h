@@ -22,16 +22,35 @@ class ElementI6 : public Element
      ~ElementI6();
 
      Shape* shape() const;
+     Element* clone() const;
 
      MatrixXd EMatrix(const VectorXd & modulus) const;
      MatrixXd BMatrix(const Vector2d & point) const;
      MatrixXd _BMatrix(const int & i) const;
 
+     /**
+      * Get the shear stiffness factor of each node pair, 1 if bonded.
+      *
+      * @return The 3-by-1 factors.
+      */
+     const Vector3d & shearFactor() const;
+
+     /**
+      * Set the shear stiffness factor of a node pair, e.g. the residual ratio once it debonds.
+      *
+      * @param pair The node pair (0, 1, 2).
+      * @param factor The factor on the shear stiffness of the material.
+      */
+     void setShearFactor(const int & pair, const double & factor);
+
  private:
      
      /** cached B matrix */
      MatrixXd B_;
 
+     /** shear stiffness factor of each node pair */
+     Vector3d shearFactor_;
+
      /** For interface element, calculate the orientation of the element */
      double _angle() const;
 
@@ -34,6 +34,11 @@ ElementQ4::~ElementQ4()
 {
 }
 
+Element* ElementQ4::clone() const
+{
+    return new ElementQ4(*this);
+}
+
 Shape* ElementQ4::shape() const
 {
     return statics.shape;
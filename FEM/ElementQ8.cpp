@@ -34,6 +34,11 @@ ElementQ8::~ElementQ8()
 {
 }
 
+Element* ElementQ8::clone() const
+{
+    return new ElementQ8(*this);
+}
+
 Shape* ElementQ8::shape() const
 {
     return statics.shape;
@@ -27,6 +27,7 @@ class ElementQ8 : public Element
         ~ElementQ8();
 
         Shape* shape() const;
+        Element* clone() const;
 
         MatrixXd EMatrix(const VectorXd & modulus) const;
         MatrixXd BMatrix(const Vector2d & point) const;
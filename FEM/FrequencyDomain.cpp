@@ -0,0 +1,246 @@
+/**
+ * @file FrequencyDomain.cpp
+ * Implementation of FrequencyDomain class.
+ */
+
+#include "FrequencyDomain.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+FrequencyDomain::FrequencyDomain(Mesh & meshInfo) : Analysis(meshInfo), frequencies(0)
+{
+    gravity = mesh.setting("gravity", 386.1);
+    rayleighMass = mesh.setting("rayleigh_mass", 10);
+    rayleighStiffness = mesh.setting("rayleigh_stiffness", 0.0002);
+    interval = mesh.setting("sample_interval", 0.0005);
+    pulseDuration = mesh.setting("pulse_duration", 0.03);
+    threadCount = std::max((int)mesh.setting("threads", 1), 1);
+    int requested = std::max((int)mesh.setting("time_samples", 256), 2);
+    samples = 2;
+    while (samples < requested)
+        samples *= 2;
+    if (samples != requested)
+        std::cerr << "WARNING: Time samples are rounded up to " << samples << " for the FFT." << std::endl;
+    if (pulseDuration >= samples * interval)
+        std::cerr << "WARNING: The pulse is longer than the sampling window." << std::endl;
+
+    std::istringstream in(mesh.settingString("sensors", ""));
+    int node;
+    while (in >> node) {
+        if (node < 0 || node >= mesh.nodeCount())
+            std::cerr << "WARNING: Sensor node " << node << " does not exist and is ignored." << std::endl;
+        else
+            sensors.push_back(node);
+    }
+    if (sensors.empty()) {
+        // The surface node on the axis, i.e., the highest node of the smallest radius
+        int center = 0;
+        for (int i = 1; i < mesh.nodeCount(); i++) {
+            const Vector2d & curr = mesh.nodeArray()[i]->getGlobalCoord();
+            const Vector2d & best = mesh.nodeArray()[center]->getGlobalCoord();
+            if (curr(0) < best(0) - 1e-9 || (std::abs(curr(0) - best(0)) <= 1e-9 && curr(1) > best(1)))
+                center = i;
+        }
+        sensors.push_back(center);
+    }
+}
+
+FrequencyDomain::~FrequencyDomain()
+{
+}
+
+void FrequencyDomain::solve()
+{
+    std::vector<bool> fixedDof(2 * mesh.nodeCount(), false);
+    for (auto & dof : mesh.boundaryNodeList)
+        fixedDof[dof] = true;
+
+    // Spatial load pattern from the point and edge loads, then K with the boundary conditions
+    applyForce();
+    VectorXd loadPattern = nodalForce;
+    for (int d = 0; d < (int)loadPattern.size(); d++)
+        if (fixedDof[d])
+            loadPattern(d) = 0;
+    assembleStiffness();
+    SparseMatrix<double> mass = assembleMass(fixedDof);
+
+    // Spectrum of the haversine pulse
+    loadHistory = VectorXd::Zero(samples);
+    std::vector<std::complex<double> > pulse(samples);
+    for (int n = 0; n < samples; n++) {
+        double t = n * interval;
+        if (t < pulseDuration)
+            loadHistory(n) = std::pow(std::sin(M_PI * t / pulseDuration), 2);
+        pulse[n] = loadHistory(n);
+    }
+    fft(pulse, false);
+
+    // The shared sparsity pattern of K + i w C - w^2 M
+    typedef SparseMatrix<std::complex<double> > ComplexMatrix;
+    ComplexMatrix complexStiffness = globalStiffness.cast<std::complex<double> >();
+    ComplexMatrix complexMass = mass.cast<std::complex<double> >();
+    ComplexMatrix pattern = complexStiffness + complexMass;
+    VectorXcd complexLoad = loadPattern.cast<std::complex<double> >();
+
+    // Frequencies where the pulse has no energy are skipped
+    int half = samples / 2;
+    double peak = 0;
+    for (int k = 0; k <= half; k++)
+        peak = std::max(peak, std::abs(pulse[k]));
+    std::vector<VectorXcd> spectrum(half + 1);
+    std::vector<int> active;
+    for (int k = 0; k <= half; k++) {
+        if (std::abs(pulse[k]) > 1e-10 * peak)
+            active.push_back(k);
+        else
+            spectrum[k] = VectorXcd::Zero(complexLoad.size());
+    }
+    frequencies = (int)active.size();
+
+    // Static round-robin assignment of the frequencies to the threads, each with its own factorization
+    auto sweep = [&](int t, int threads) {
+        SparseLU<ComplexMatrix, COLAMDOrdering<int> > solver;
+        solver.analyzePattern(pattern);
+        for (int a = t; a < (int)active.size(); a += threads) {
+            int k = active[a];
+            double w = 2 * M_PI * k / (samples * interval);
+            std::complex<double> stiffnessFactor(1, w * rayleighStiffness);
+            std::complex<double> massFactor(-w * w, w * rayleighMass);
+            ComplexMatrix system = stiffnessFactor * complexStiffness + massFactor * complexMass;
+            solver.factorize(system);
+            if (solver.info() != Success) {
+                std::cerr << "WARNING: The dynamic stiffness matrix is singular at " << w / (2 * M_PI) << " Hz." << std::endl;
+                spectrum[k] = VectorXcd::Zero(complexLoad.size());
+                continue;
+            }
+            spectrum[k] = solver.solve(pulse[k] * complexLoad);
+        }
+    };
+    int threads = std::min(threadCount, std::max(frequencies, 1));
+    if (threads <= 1)
+        sweep(0, 1);
+    else {
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++)
+            pool.push_back(std::thread(sweep, t, threads));
+        for (auto & thread : pool)
+            thread.join();
+    }
+    std::cout << "Frequencies solved = " << frequencies << " of " << half + 1 << ", " << samples << " time samples at dt = " << interval << std::endl;
+
+    // Deflection history at the sensors by inverse FFT of the conjugate-symmetric spectrum
+    deflectionHistory = MatrixXd::Zero(samples, sensors.size());
+    for (int s = 0; s < (int)sensors.size(); s++) {
+        int dof = 2 * sensors[s] + 1;
+        std::vector<std::complex<double> > data(samples);
+        for (int k = 0; k <= half; k++)
+            data[k] = spectrum[k](dof);
+        for (int k = half + 1; k < samples; k++)
+            data[k] = std::conj(data[samples - k]);
+        fft(data, true);
+        for (int n = 0; n < samples; n++)
+            deflectionHistory(n, s) = data[n].real() / samples;
+    }
+
+    // Displacement field at the peak deflection of the first sensor
+    int peakSample = 0;
+    deflectionHistory.col(0).cwiseAbs().maxCoeff(&peakSample);
+    double t = peakSample * interval;
+    std::cout << "Peak deflection " << deflectionHistory(peakSample, 0) << " at node " << sensors[0] << ", t = " << t << std::endl;
+    VectorXcd field = spectrum[0];
+    for (int k = 1; k <= half; k++) {
+        double w = 2 * M_PI * k / (samples * interval);
+        field += (k < half ? 2.0 : 1.0) * std::exp(std::complex<double>(0, w * t)) * spectrum[k];
+    }
+    nodalDisp = field.real() / samples;
+
+    // Compute strain and stress and accumulate at each node
+    computeStrainAndStress();
+
+    // Average strain and stress at each node
+    averageStrainAndStress();
+}
+
+void FrequencyDomain::writeHistory(std::string const & fileName) const
+{
+    std::ofstream file(fileName.c_str());
+    if (!file) {
+        std::cerr << "WARNING: Cannot write deflection history " << fileName << "." << std::endl;
+        return;
+    }
+    file << "time,load";
+    for (auto & node : sensors)
+        file << ",node_" << node;
+    file << "\n";
+    file.precision(10);
+    for (int n = 0; n < (int)loadHistory.size(); n++) {
+        file << n * interval << "," << loadHistory(n);
+        for (int s = 0; s < (int)sensors.size(); s++)
+            file << "," << deflectionHistory(n, s);
+        file << "\n";
+    }
+}
+
+SparseMatrix<double> FrequencyDomain::assembleMass(const std::vector<bool> & fixedDof) const
+{
+    typedef Eigen::Triplet<double> T;
+    std::vector<T> tripletList;
+    tripletList.reserve(mesh.elementCount() * 16 * 16);
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        Element* curr = mesh.elementArray()[i];
+        if (curr->material()->geosynthetic)
+            continue; // membranes and interfaces are massless
+        double density = curr->material()->bodyForce().norm() / gravity;
+        if (density == 0)
+            continue;
+        MatrixXd localMass = curr->computeMass(density);
+        const VectorXi & nodeList = curr->getNodeList();
+        for (int a = 0; a < localMass.rows(); a++) {
+            int row = 2 * nodeList(a / 2) + a % 2;
+            if (fixedDof[row])
+                continue;
+            for (int b = 0; b < localMass.cols(); b++) {
+                int col = 2 * nodeList(b / 2) + b % 2;
+                if (!fixedDof[col])
+                    tripletList.push_back(T(row, col, localMass(a, b)));
+            }
+        }
+    }
+    SparseMatrix<double> mass(2 * mesh.nodeCount(), 2 * mesh.nodeCount());
+    mass.setFromTriplets(tripletList.begin(), tripletList.end());
+    mass.makeCompressed();
+    return mass;
+}
+
+void FrequencyDomain::fft(std::vector<std::complex<double> > & data, const bool & inverse)
+{
+    int n = (int)data.size();
+    // Bit-reversal permutation
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+    // Butterflies of doubling length
+    for (int length = 2; length <= n; length <<= 1) {
+        double angle = 2 * M_PI / length * (inverse ? 1 : -1);
+        std::complex<double> root(std::cos(angle), std::sin(angle));
+        for (int start = 0; start < n; start += length) {
+            std::complex<double> w(1, 0);
+            for (int k = 0; k < length / 2; k++) {
+                std::complex<double> even = data[start + k];
+                std::complex<double> odd = data[start + k + length / 2] * w;
+                data[start + k] = even + odd;
+                data[start + k + length / 2] = even - odd;
+                w *= root;
+            }
+        }
+    }
+}
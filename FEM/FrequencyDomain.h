@@ -0,0 +1,102 @@
+/**
+ * @file FrequencyDomain.h
+ * Derived class from Analysis for frequency-domain dynamic (FWD) problems.
+ */
+
+#ifndef FrequencyDomain_h
+#define FrequencyDomain_h
+
+#include "Analysis.h"
+#include <complex>
+#include <string>
+#include <vector>
+
+/* Derived class for the dynamic response to an impulse load such as a falling
+ * weight deflectometer (FWD) drop.
+ *
+ * The point and edge loads give the spatial load pattern F and a haversine
+ * pulse p(t) its time history. The pulse is sampled over a window of N points
+ * and transformed by FFT, and at each frequency w_k = 2 PI k / (N dt) the
+ * complex system
+ *
+ *   (K + i w C - w^2 M) U_k = P_k F,  C = alpha M + beta K (Rayleigh damping)
+ *
+ * is solved, with the consistent mass M = int rho N^T N dV of the Q4/Q8
+ * elements and rho = |body force| / g. The frequencies are independent and are
+ * solved in parallel threads; all the complex matrices share the sparsity
+ * pattern of K + M, so each thread does the symbolic analysis once and then only
+ * the numerical factorization per frequency. The deflection histories at the
+ * sensor nodes are synthesized by inverse FFT, and the displacement field at the
+ * peak deflection of the first sensor is kept as the nodal result.
+ *
+ * The response is periodic in the window, so it should be long enough for the
+ * response to die out. The body force and thermal load are static and excluded;
+ * nonlinear layers take their initial moduli from the input, without the
+ * stress-dependent iteration (a warning is printed).
+ *
+ * Settings:
+ *   gravity            the gravitational acceleration converting unit weight to density (386.1)
+ *   rayleigh_mass      alpha (10)
+ *   rayleigh_stiffness beta (0.0002)
+ *   time_samples       N, rounded up to a power of 2 (256)
+ *   sample_interval    dt (0.0005)
+ *   pulse_duration     the haversine pulse duration (0.03)
+ *   sensors            the sensor node indices (default the surface node on the axis)
+ *   threads            the number of threads (1)
+ */
+class FrequencyDomain : public Analysis
+{
+  public:
+    /* See the documentation of base class Analysis.
+     */
+    FrequencyDomain(Mesh & meshInfo);
+    ~FrequencyDomain();
+    void solve();
+
+    /**
+     * Write the load and the vertical deflection history at each sensor to a
+     * CSV file.
+     *
+     * @param fileName The output file name.
+     */
+    void writeHistory(std::string const & fileName) const;
+
+  private:
+    /** Damping and time sampling parameters */
+    double gravity; /* unit weight to density */
+    double rayleighMass; /* alpha */
+    double rayleighStiffness; /* beta */
+    int samples; /* N, a power of 2 */
+    double interval; /* dt */
+    double pulseDuration; /* haversine duration */
+    int threadCount; /* threads of the frequency sweep */
+
+    /** The sensor node indices */
+    std::vector<int> sensors;
+
+    /** The sampled load factor and the N-by-sensors vertical deflection history */
+    VectorXd loadHistory;
+    MatrixXd deflectionHistory;
+
+    /** The number of frequencies solved */
+    int frequencies;
+
+    /**
+     * Assemble the consistent mass matrix, with the rows and columns of the
+     * fixed DOFs removed.
+     *
+     * @param fixedDof Whether each DOF is prescribed.
+     * @return The global mass matrix.
+     */
+    SparseMatrix<double> assembleMass(const std::vector<bool> & fixedDof) const;
+
+    /**
+     * In-place radix-2 fast Fourier transform.
+     *
+     * @param data The sequence, of a power of 2 length.
+     * @param inverse Whether to apply the inverse transform (without the 1/N scaling).
+     */
+    static void fft(std::vector<std::complex<double> > & data, const bool & inverse);
+};
+
+#endif /* FrequencyDomain_h */
@@ -17,6 +17,9 @@ Geosynthetic::Geosynthetic(const bool & anisotropy, const bool & nonlinearity, c
     double t = properties[i++]; t_ = t;
     double ks = properties[i++]; ks_ = ks;
     double kn = properties[i++]; kn_ = kn;
+    // optional for I6 interface elements: shear strength and residual shear stiffness ratio after debonding
+    tauMax_ = properties.size() > 5 ? properties[i++] : 0;
+    residual_ = properties.size() > 6 ? properties[i++] : 0.01;
 
     E_ = MatrixXd::Zero(2,2);
     E_ << 1, v,
@@ -41,4 +44,14 @@ double Geosynthetic::getInterfaceShearStiffness() const
 double Geosynthetic::getInterfaceNormalStiffness() const
 {
     return kn_;
-}
\ No newline at end of file
+}
+
+double Geosynthetic::getInterfaceShearStrength() const
+{
+    return tauMax_;
+}
+
+double Geosynthetic::getInterfaceResidualRatio() const
+{
+    return residual_;
+}
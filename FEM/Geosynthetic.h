@@ -21,6 +21,8 @@ class Geosynthetic : public Material
     // override
     double getInterfaceShearStiffness() const;
     double getInterfaceNormalStiffness() const;
+    double getInterfaceShearStrength() const;
+    double getInterfaceResidualRatio() const;
 
   protected:
     /** Geosynthetic material properties is different from the base defintion
@@ -35,6 +37,12 @@ class Geosynthetic : public Material
 
     /** normal stiffness */  
     double kn_;
+
+    /** shear strength of the interface, 0 if it never debonds */
+    double tauMax_;
+
+    /** debonded to bonded shear stiffness ratio */
+    double residual_;
 };
 
 #endif /* Geosynthetic_h */
@@ -7,11 +7,23 @@
  */
 
 #include "Linear.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 
-Linear::Linear(Mesh & meshInfo) : Analysis(meshInfo)
+Linear::Linear(Mesh & meshInfo) : Analysis(meshInfo),
+    slipIterations(std::max((int)mesh.setting("slip_iterations", 20), 0)),
+    updateRank(std::max((int)mesh.setting("update_rank", 20), 0))
 {
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        Element* curr = mesh.elementArray()[i];
+        if (curr->getSize() == 6 && curr->material()->geosynthetic && curr->material()->getInterfaceShearStrength() > 0)
+            slipInterfaces.push_back(static_cast<ElementI6*>(curr));
+    }
+    fixedDof.assign(2 * mesh.nodeCount(), false);
+    for (auto & dof : mesh.boundaryNodeList)
+        fixedDof[dof] = true;
 }
 
 Linear::~Linear()
@@ -52,6 +64,70 @@ void Linear::solve()
     SimplicialLDLT <SparseMatrix<double> > solver;
     solver.compute(globalStiffness);
     nodalDisp = solver.solve(nodalForce);
+
+    // Interface debonding: the pairs debonded since the last factorization enter as low-rank updates
+    std::vector<SlipUpdate> updates;
+    std::vector<bool> changed(mesh.elementCount(), false);
+    MatrixXd Z(nodalDisp.size(), 0); // K^-1 U
+    int factorizations = 1;
+    int pairs = 0;
+    for (int it = 1; it <= slipIterations && !slipInterfaces.empty(); it++) {
+        int first = (int)updates.size();
+        pairs = debond(updates, changed);
+        if (pairs == 0)
+            break;
+
+        if ((int)updates.size() > updateRank) {
+            // Too many changes for the updates to pay off: reassemble the changed interfaces and refactorize
+            staleElement = changed;
+            applyForce();
+            assembleStiffness();
+            solver.factorize(globalStiffness);
+            nodalDisp = solver.solve(nodalForce);
+            factorizations++;
+            updates.clear();
+            changed.assign(mesh.elementCount(), false);
+            Z.resize(nodalDisp.size(), 0);
+        } else {
+            // K' = K + U D U^T, with a new column of U and Z = K^-1 U for each new pair
+            int rank = (int)updates.size();
+            Z.conservativeResize(NoChange, rank);
+            for (int k = first; k < rank; k++) {
+                VectorXd u = VectorXd::Zero(nodalDisp.size());
+                if (updates[k].lower >= 0) u(updates[k].lower) = -1;
+                if (updates[k].upper >= 0) u(updates[k].upper) = 1;
+                Z.col(k) = solver.solve(u);
+            }
+
+            // The coupling of a pair to a prescribed displacement moves to the load side
+            VectorXd force = nodalForce;
+            MatrixXd S = MatrixXd::Zero(rank, rank); // D^-1 + U^T Z
+            for (int k = 0; k < rank; k++) {
+                const SlipUpdate & update = updates[k];
+                S(k, k) = 1 / update.stiffness;
+                if (update.lower >= 0) {
+                    force(update.lower) += update.stiffness * update.fixedForce;
+                    S.row(k) -= Z.row(update.lower);
+                }
+                if (update.upper >= 0) {
+                    force(update.upper) -= update.stiffness * update.fixedForce;
+                    S.row(k) += Z.row(update.upper);
+                }
+            }
+            VectorXd x = solver.solve(force);
+            VectorXd y = VectorXd::Zero(rank); // U^T K^-1 f
+            for (int k = 0; k < rank; k++) {
+                if (updates[k].lower >= 0) y(k) -= x(updates[k].lower);
+                if (updates[k].upper >= 0) y(k) += x(updates[k].upper);
+            }
+            nodalDisp = x - Z * S.partialPivLu().solve(y);
+        }
+        std::cout << "Slip iteration No." << it << ": " << pairs << " node pairs debonded, update rank = " << updates.size() << std::endl;
+    }
+    if (pairs > 0)
+        std::cerr << "WARNING: Interface debonding not settled in " << slipIterations << " slip iterations, " << pairs << " node pairs debonded in the last one." << std::endl;
+    if (!slipInterfaces.empty())
+        std::cout << "Factorizations = " << factorizations << std::endl;
     //
     // start = std::chrono::high_resolution_clock::now();
     //     // SparseLU <SparseMatrix<double> > solver;
@@ -73,3 +149,33 @@ void Linear::solve()
     // Average strain and stress at each node
     averageStrainAndStress();
 }
+
+int Linear::debond(std::vector<SlipUpdate> & updates, std::vector<bool> & changed)
+{
+    int pairs = 0;
+    for (auto & curr : slipInterfaces) {
+        const VectorXi & nodeList = curr->getNodeList();
+        const Material* material = curr->material();
+        MatrixXd E = curr->EMatrix(Vector2d::Zero());
+        for (int n = 0; n < 3; n++) {
+            if (curr->shearFactor()(n) != 1)
+                continue; // debonded already
+            // Node pair n is bottom node n and top node n + 3, its shear row in E is 2n
+            int lower = 2 * nodeList(n), upper = 2 * nodeList(n + 3);
+            double shear = material->getInterfaceShearStiffness() * (nodalDisp(upper) - nodalDisp(lower));
+            if (std::abs(shear) <= material->getInterfaceShearStrength())
+                continue;
+            SlipUpdate update;
+            update.stiffness = E(2 * n, 2 * n) * (material->getInterfaceResidualRatio() - 1);
+            update.lower = fixedDof[lower] ? -1 : lower;
+            update.upper = fixedDof[upper] ? -1 : upper;
+            update.fixedForce = (fixedDof[upper] ? nodalDisp(upper) : 0) - (fixedDof[lower] ? nodalDisp(lower) : 0);
+            if (update.stiffness != 0 && (update.lower >= 0 || update.upper >= 0))
+                updates.push_back(update);
+            curr->setShearFactor(n, material->getInterfaceResidualRatio());
+            changed[curr->getIndex()] = true;
+            pairs++;
+        }
+    }
+    return pairs;
+}
@@ -11,8 +11,22 @@
 #define Linear_h
 
 #include "Analysis.h"
+#include "ElementI6.h"
 
 /* Derived class for solving linear elastic problems.
+ *
+ * Interfaces (I6) with a shear strength debond where the shear stress exceeds
+ * it: the shear stiffness of the node pair drops to the residual ratio and the
+ * problem is solved again, until no more pairs debond. A debonded pair changes
+ * K by d b b^T, with b the relative shear displacement of the pair, so the
+ * changes since the last factorization form K' = K + U D U^T and are solved by
+ * the Woodbury identity
+ *
+ *   K'^-1 f = K^-1 f - Z (D^-1 + U^T Z)^-1 U^T K^-1 f,  Z = K^-1 U,
+ *
+ * with one solve per new pair instead of a refactorization. K is refactorized
+ * when the rank would exceed the "update_rank" setting (20); "slip_iterations"
+ * (20) limits the iterations.
  */
 class Linear : public Analysis
 {
@@ -23,6 +37,33 @@ class Linear : public Analysis
     ~Linear();
     void solve();
 
+  private:
+    /** A low-rank stiffness change d b b^T of a debonded node pair */
+    struct SlipUpdate {
+        int lower, upper; /* shear DOFs of the pair, -1 if fixed */
+        double stiffness; /* d */
+        double fixedForce; /* b^T u over the fixed DOFs */
+    };
+
+    /** Slip iteration parameters */
+    int slipIterations; /* maximum iterations */
+    int updateRank; /* maximum rank of the updates before a refactorization */
+
+    /** The interface elements that can debond */
+    std::vector<ElementI6*> slipInterfaces;
+
+    /** Whether each DOF is prescribed */
+    std::vector<bool> fixedDof;
+
+    /**
+     * Debond the node pairs whose shear stress exceeds the shear strength.
+     *
+     * @param updates The stiffness changes of the debonded pairs, appended.
+     * @param changed Whether each element has debonded pairs, updated.
+     * @return The number of debonded pairs.
+     */
+    int debond(std::vector<SlipUpdate> & updates, std::vector<bool> & changed);
+
 };
 
 #endif /* Linear_h */
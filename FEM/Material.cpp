@@ -9,11 +9,12 @@
 #include "Material.h"
 
 Material::Material()
+  : fastMath(false)
 {
 }
 
 Material::Material(const bool & Anisotropy, const bool & Nonlinearity, const bool & NoTension, const bool & Geosynthetic)
-  : anisotropy(Anisotropy), nonlinearity(Nonlinearity), noTension(NoTension), geosynthetic(Geosynthetic), E_(MatrixXd::Zero(4,4)), thermalStrain_(VectorXd::Zero(4))
+  : anisotropy(Anisotropy), nonlinearity(Nonlinearity), noTension(NoTension), geosynthetic(Geosynthetic), fastMath(false), E_(MatrixXd::Zero(4,4)), thermalStrain_(VectorXd::Zero(4))
 {
 }
 
@@ -41,12 +42,46 @@ const double & Material::modulusG() const
     return G_;
 }
 
+const double & Material::poisson() const
+{
+    return v_;
+}
+
+const double & Material::poissonR() const
+{
+    return vr_;
+}
+
+const double & Material::poissonZ() const
+{
+    return vz_;
+}
+
 void Material::adjustModulus(const double & ratio)
 {
     (void)ratio; // silence warning
     return;
 }
 
+int Material::model() const
+{
+    return 0;
+}
+
+std::vector<double> Material::parameters() const
+{
+    std::vector<double> list;
+    if (!anisotropy)
+        list = {M_, v_};
+    else
+        list = {Mr_, Mz_, G_, vr_, vz_};
+    list.push_back(bodyForce_(0));
+    list.push_back(bodyForce_(1));
+    for (int i = 0; i < thermalStrain_.size(); i++)
+        list.push_back(thermalStrain_(i));
+    return list;
+}
+
 const MatrixXd & Material::EMatrix() const
 {
     return E_;
@@ -58,6 +93,24 @@ VectorXd Material::stressDependentModulus(const VectorXd & stress) const
     return VectorXd::Zero(3); // to silent warning
 }
 
+void Material::stressDependentModulus(const int & n, const double* sigma3, const double* sigma2, const double* sigma1, double* Mr, double* Mz, double* G) const
+{
+    VectorXd principal(3);
+    for (int k = 0; k < n; k++) {
+        principal << sigma3[k], sigma2[k], sigma1[k];
+        VectorXd modulus = stressDependentModulus(principal);
+        Mr[k] = modulus(0);
+        Mz[k] = modulus(1);
+        G[k] = modulus(2);
+    }
+}
+
+VectorXd Material::modulusGradient(const VectorXd & stress) const
+{
+    (void)stress; // silence warning
+    return VectorXd::Zero(4);
+}
+
 MatrixXd Material::EMatrix(const VectorXd & modulus) const
 {
     (void)modulus; // silence warning
@@ -93,3 +146,13 @@ double Material::getInterfaceNormalStiffness() const
 {
     return 0;
 }
+
+double Material::getInterfaceShearStrength() const
+{
+    return 0;
+}
+
+double Material::getInterfaceResidualRatio() const
+{
+    return 1;
+}
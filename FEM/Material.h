@@ -49,6 +49,15 @@ class Material
     const double & modulusR() const;
     const double & modulusZ() const;
     const double & modulusG() const;
+
+    /**
+     * Get the Poisson's ratio of the element.
+     *
+     * @return The isotropic, horizontal or vertical Poisson's ratio.
+     */
+    const double & poisson() const;
+    const double & poissonR() const;
+    const double & poissonZ() const;
     
     /**
      * Adjust the modulus by ratio. Used in back analysis scheme.
@@ -57,6 +66,23 @@ class Material
      */
     virtual void adjustModulus(const double & ratio);
 
+    /**
+     * Get the parameters that determine the response of the material: the
+     * moduli, Poisson's ratios, body force and thermal strain, and (in derived
+     * classes) the model coefficients. Used to compare analyses of one mesh.
+     *
+     * @return The parameter list.
+     */
+    virtual std::vector<double> parameters() const;
+
+    /**
+     * Get the designator of the constitutive model. Analyses whose materials
+     * use different models are not comparable by their parameters.
+     *
+     * @return The resilient model No. of nonlinear materials, 0 otherwise.
+     */
+    virtual int model() const;
+
     /**
      * Get the stress-strain constitutive matrix of the element. Linear elastic
      * material will use this to get the constant E matrix.
@@ -86,6 +112,27 @@ class Material
      */
     virtual VectorXd stressDependentModulus(const VectorXd & stress) const;
 
+    /**
+     * Compute the stress-dependent resilient modulus of a batch of Gaussian
+     * points stored as arrays. The default evaluates the single-point version
+     * at each point.
+     *
+     * @param n The number of points.
+     * @param sigma3, sigma2, sigma1 The principal stresses of each point.
+     * @param Mr, Mz, G The horizontal, vertical & shear modulus of each point.
+     */
+    virtual void stressDependentModulus(const int & n, const double* sigma3, const double* sigma2, const double* sigma1, double* Mr, double* Mz, double* G) const;
+
+    /**
+     * Compute the gradient of the stress-dependent resilient modulus with
+     * respect to the stress components. Used in the Newton scheme to form the
+     * consistent tangent (isotropic models only).
+     *
+     * @param stress Stresses in cylindrical coordinates, sigma_r, sigma_theta, sigma_z, tau_rz.
+     * @return The 4-by-1 gradient dM/dsigma.
+     */
+    virtual VectorXd modulusGradient(const VectorXd & stress) const;
+
     /**
      * Get the body force to be used in the load condition.
      *
@@ -119,6 +166,18 @@ class Material
      */
     virtual double getInterfaceNormalStiffness() const;
 
+    /**
+     * Get the shear strength of I6 element, beyond which the interface debonds.
+     * @note override in Geosynthetic derived class only, 0 for no debonding
+     */
+    virtual double getInterfaceShearStrength() const;
+
+    /**
+     * Get the ratio of the debonded to the bonded shear stiffness of I6 element.
+     * @note override in Geosynthetic derived class only
+     */
+    virtual double getInterfaceResidualRatio() const;
+
     /**
      * Assign the thermal strain to allow incremental loading in nonlinear scheme.
      *
@@ -138,6 +197,9 @@ class Material
     /** A sign for geosynthetic material. 0 if not geosynthetic (default for all non-geo material), 1 if geosynthetic (initialized specifically in Geosynthetic class). */
     bool geosynthetic;    
 
+    /** A sign for the fast power in the stress-dependent moduli. 0 for std::pow (default), 1 for fastPow() of FastMath.h. Every modulus evaluation, batched or single-point (geostatic stress, Newton tangent, modulus change), goes through the same model evaluate(), so the flag applies to all of them. */
+    bool fastMath;
+
   protected:
 
     /** The Young's/Resilient modulus. Will be assigned in derived class for both linear and nonlinear (the initial guess Modulus) materials */
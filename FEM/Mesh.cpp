@@ -12,22 +12,44 @@
 #include "ElementQ8.h"
 #include "LinearElastic.h"
 #include "NonlinearElastic.h"
+#include "ViscoElastic.h"
 #include "Geosynthetic.h"
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <sstream>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <cstring>
 
 Mesh::Mesh()
+  : nodeCount_(0), elementCount_(0), meshNode_(NULL), meshElement_(NULL), ownsMaterials_(true)
 {
 }
 
 Mesh::Mesh(std::string const & fileName)
+  : ownsMaterials_(true)
 {
     readFromFile(fileName);
 }
 
+Mesh::Mesh(Mesh const & other)
+  : materialList(other.materialList), iterations(other.iterations),
+    boundaryNodeList(other.boundaryNodeList), boundaryValue(other.boundaryValue),
+    loadNodeList(other.loadNodeList), loadValue(other.loadValue),
+    loadElementList(other.loadElementList), loadEdgeList(other.loadEdgeList), edgeLoadValue(other.edgeLoadValue),
+    bodyForce(other.bodyForce), nonlinear(other.nonlinear), viscoelastic(other.viscoelastic), settings(other.settings),
+    nodeCount_(other.nodeCount_), elementCount_(other.elementCount_), ownsMaterials_(false)
+{
+    meshNode_ = new Node*[nodeCount_];
+    for (int i = 0; i < nodeCount_; i++)
+        meshNode_[i] = new Node(*other.meshNode_[i]);
+    meshElement_ = new Element*[elementCount_];
+    for (int i = 0; i < elementCount_; i++)
+        meshElement_[i] = other.meshElement_[i]->clone();
+}
+
 Mesh::~Mesh()
 {
     // Delete all nodes
@@ -42,9 +64,11 @@ Mesh::~Mesh()
     }
     delete[] meshElement_; meshElement_ = NULL;
 
-    // Delete all materials
-    for (auto & m : materialList) {
-        delete m; m = NULL;
+    // Delete all materials (a forked mesh shares them with the original one)
+    if (ownsMaterials_) {
+        for (auto & m : materialList) {
+            delete m; m = NULL;
+        }
     }
 
 }
@@ -98,6 +122,7 @@ void Mesh::readFromFile(std::string const & fileName)
     std::vector<double> elementProperty;
     materialList.reserve(elementProperties);
     nonlinear = false;
+    viscoelastic = false;
     for (int i = 0; i < elementProperties; i++) {
         std::getline(file, readLine);
         std::vector<int> range;
@@ -105,7 +130,7 @@ void Mesh::readFromFile(std::string const & fileName)
         // range[0]: starting element ID
         // range[1]: ending element ID
         // range[2]: 0 if isotropic, 1 if cross-anisotropic
-        // range[3]: 0 if linear elastic, 1 if nonlinear elastic
+        // range[3]: 0 if linear elastic, 1 if nonlinear elastic, 2 if viscoelastic
         // range[4]:  0 if normal material, 1 if no-tension material
         // range[5]: 0 if normal material, 1 if geosynthetic material
         layerMap[range[0]] = i; // record the lower bound of the range
@@ -115,6 +140,18 @@ void Mesh::readFromFile(std::string const & fileName)
         {   // non-geosynthetic layer
             if (range[3] == 0) // linear elastic
                 materialList.push_back(new LinearElastic(range[2], range[3], range[4], range[5], elementProperty)); // dynamically allocated, remember to delete in destructor!
+            else if (range[3] == 2) { // viscoelastic
+                viscoelastic = true;
+                // for viscoelastic layer it should read two more lines about the number of Prony terms and the (g, k, tau) of each term
+                std::getline(file, readLine);
+                int terms = std::stoi(readLine, NULL);
+                std::getline(file, readLine);
+                std::vector<double> prony;
+                parseLine(readLine, prony);
+                if ((int)prony.size() != 3 * terms)
+                    std::cerr << "WARNING: A viscoelastic layer lists " << prony.size() << " Prony values for " << terms << " terms, expected (g, k, tau) of each term." << std::endl;
+                materialList.push_back(new ViscoElastic(range[2], false, range[4], range[5], elementProperty, prony));
+            }
             else { // nonlinear elastic
                 nonlinear = true;
                 // for nonlinear layer it should read two more lines about the material model parameters
@@ -287,6 +324,29 @@ void Mesh::readFromFile(std::string const & fileName)
         std::vector<double>().swap(boundaryYValue);
     }
 
+    // -------------------------------------------------------------------------
+    // ------------------------ Analysis Settings (optional) -------------------
+    // -------------------------------------------------------------------------
+    // Any remaining lines are optional "keyword value" pairs that switch on
+    // solver options, e.g. "solver pcg" or "refactor_iterations 20". Empty lines
+    // and lines starting with '#' are skipped. Old input files simply end here.
+    settings.clear();
+    while (std::getline(file, readLine)) {
+        std::string::size_type start = readLine.find_first_not_of(" \t\r");
+        if (start == std::string::npos || readLine[start] == '#')
+            continue;
+        std::string::size_type j = readLine.find_first_of(" \t", start);
+        std::string key = readLine.substr(start, j == std::string::npos ? std::string::npos : j - start);
+        std::string value;
+        if (j != std::string::npos) {
+            std::string::size_type k = readLine.find_first_not_of(" \t", j);
+            std::string::size_type end = readLine.find_last_not_of(" \t\r");
+            if (k != std::string::npos)
+                value = readLine.substr(k, end - k + 1);
+        }
+        settings[key] = value;
+    }
+
     // Complete read-in
     file.close();
 }
@@ -321,6 +381,26 @@ Element** Mesh::elementArray() const
     return meshElement_;
 }
 
+double Mesh::setting(std::string const & key, const double & fallback) const
+{
+    std::map<std::string, std::string>::const_iterator it = settings.find(key);
+    if (it == settings.end() || it->second.empty())
+        return fallback;
+    std::stringstream ss(it->second);
+    double value;
+    if (!(ss >> value))
+        return fallback;
+    return value;
+}
+
+std::string Mesh::settingString(std::string const & key, std::string const & fallback) const
+{
+    std::map<std::string, std::string>::const_iterator it = settings.find(key);
+    if (it == settings.end() || it->second.empty())
+        return fallback;
+    return it->second;
+}
+
 template<typename T>
 void Mesh::parseLine(std::string const & readLine, std::vector<T> & parseLine) const
 {
@@ -357,3 +437,63 @@ void Mesh::parseLine(std::string const & readLine, std::vector<T> & parseLine) c
     // for(auto & e : v)
     //     std::cout << e << " "; // output is exactly the same
 }
+
+/* FNV-1a over the bytes of a value */
+template <typename T>
+static void hashValue(std::uint64_t & hash, const T & value)
+{
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    for (unsigned i = 0; i < sizeof(T); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+std::uint64_t Mesh::fingerprint() const
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    hashValue(hash, nodeCount_);
+    hashValue(hash, elementCount_);
+    for (int i = 0; i < nodeCount_; i++) {
+        const Vector2d & coord = meshNode_[i]->getGlobalCoord();
+        hashValue(hash, coord(0));
+        hashValue(hash, coord(1));
+    }
+    for (int i = 0; i < elementCount_; i++) {
+        Element* curr = meshElement_[i];
+        const VectorXi & nodeList = curr->getNodeList();
+        hashValue(hash, curr->getSize());
+        for (int j = 0; j < curr->getSize(); j++)
+            hashValue(hash, nodeList(j));
+        hashValue(hash, (int)(std::find(materialList.begin(), materialList.end(), curr->material()) - materialList.begin()));
+    }
+    for (auto & dof : boundaryNodeList)
+        hashValue(hash, dof);
+    return hash;
+}
+
+std::uint64_t Mesh::loadFingerprint() const
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (auto & m : materialList) {
+        std::vector<double> parameters = m->parameters();
+        hashValue(hash, parameters.size());
+        for (auto & p : parameters)
+            hashValue(hash, p);
+    }
+    for (auto & v : boundaryValue)
+        hashValue(hash, v);
+    for (int i = 0; i < (int)loadNodeList.size(); i++) {
+        hashValue(hash, loadNodeList[i]);
+        hashValue(hash, loadValue[i]);
+    }
+    for (int i = 0; i < (int)loadElementList.size(); i++) {
+        hashValue(hash, loadElementList[i]);
+        for (auto & edge : loadEdgeList[i])
+            hashValue(hash, edge);
+        for (auto & p : edgeLoadValue[i])
+            hashValue(hash, p);
+    }
+    return hash;
+}
@@ -14,6 +14,8 @@
 #include "Element.h"
 #include "Material.h"
 #include <vector>
+#include <map>
+#include <cstdint>
 
 /* Mesh class for storing the node, element, material, boundary, load
  * information read from input file.
@@ -33,6 +35,19 @@ class Mesh
          */
         Mesh(std::string const & fileName);
 
+        /**
+         * Copy constructor to fork a mesh, e.g. to run a load case from a
+         * converged state. Nodes and elements (with their Gaussian-point moduli)
+         * are deep-copied; the materials are shared with and owned by the
+         * original mesh, which must outlive the copy. The shared materials
+         * are not synchronized: they must stay unmodified (e.g. no
+         * Material::setBodyForce() or change of Material::fastMath) while forks are used
+         * concurrently.
+         *
+         * @param other The mesh to be forked.
+         */
+        Mesh(Mesh const & other);
+
         /**
          * Destructor for Mesh.
          */
@@ -92,6 +107,43 @@ class Mesh
          */
         Element** elementArray() const;
 
+        /**
+         * Get a numeric analysis setting.
+         *
+         * @param key The keyword of the setting.
+         * @param fallback The value to use when the setting is not given.
+         * @return The first value of the setting line, or the fallback.
+         */
+        double setting(std::string const & key, const double & fallback) const;
+
+        /**
+         * Get a text analysis setting.
+         *
+         * @param key The keyword of the setting.
+         * @param fallback The value to use when the setting is not given.
+         * @return The whole value string of the setting line, or the fallback.
+         */
+        std::string settingString(std::string const & key, std::string const & fallback) const;
+
+        /**
+         * Get a fingerprint of the mesh, the 64-bit FNV-1a hash of the node
+         * coordinates, the element connectivity and materials, and the
+         * boundary DOFs. Used to match saved analysis states to the mesh.
+         *
+         * @return The fingerprint.
+         */
+        std::uint64_t fingerprint() const;
+
+        /**
+         * Get a fingerprint of the problem on the mesh, the 64-bit FNV-1a hash
+         * of the material parameters (see Material::parameters()), the
+         * prescribed boundary values and the point and edge loads. Saved states
+         * that only hold for one problem are matched to both fingerprints.
+         *
+         * @return The fingerprint.
+         */
+        std::uint64_t loadFingerprint() const;
+
         /** A list of layered materials */
         std::vector<Material*> materialList;
 
@@ -130,6 +182,15 @@ class Mesh
         /** Analysis type */
         bool nonlinear;
 
+        /** Whether any layer is viscoelastic (time-dependent analysis) */
+        bool viscoelastic;
+
+        /** Optional analysis settings read from the "keyword value" lines at
+         * the end of the input file, e.g. "solver pcg". Settings that are not
+         * given keep their default behavior.
+         */
+        std::map<std::string, std::string> settings;
+
     private:
         /** Total number of nodes */
         int nodeCount_;
@@ -149,6 +210,12 @@ class Mesh
         /** A pointer to the node pool */
         Element** meshElement_;
 
+        /** Whether the materials are deleted with the mesh, false for a forked mesh */
+        bool ownsMaterials_;
+
+        /** Forked meshes share the materials, so assignment is not allowed */
+        Mesh const & operator=(Mesh const & other);
+
         /**
          * A templated private helper function for readFromFile().
          *
@@ -53,6 +53,11 @@ void Node::copy_(Node const & other)
     strain_ = other.strain_;
     stress_ = other.stress_;
     averageCount_ = other.averageCount_;
+    membraneStrain_ = other.membraneStrain_;
+    membraneStress_ = other.membraneStress_;
+    averageMembraneCount_ = other.averageMembraneCount_;
+    interfaceStress_ = other.interfaceStress_;
+    averageInterfaceCount_ = other.averageInterfaceCount_;
 }
 
 void Node::setGlobalCoord(const double & x, const double & y)
@@ -6,18 +6,169 @@
  * @date May 19, 2018
  */
 
+// for use of M_PI
+#define _USE_MATH_DEFINES
 #include "Nonlinear.h"
+#include "Elasticity.h"
+#include "PointLocator.h"
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 #include <functional>
 
-Nonlinear::Nonlinear(Mesh & meshInfo) : Analysis(meshInfo)
+// Elements per chunk of the parallel sweep, and Gauss points per chunk of the
+// batched constitutive update. Fixed, so that the chunked reductions give the
+// same result for any number of threads
+static const int sweepChunk = 64;
+static const int batchChunk = 1024;
+
+/* Stress of each Gaussian point of an element into the batch, sigma = E_(i-1) * (e - e0)
+ * with the E matrix of the previous iteration built by a fixed-size builder */
+template <class Elasticity>
+static void setPointStress(Element* curr, const Elasticity & elasticity, const VectorXd & nodeDisp, const int & first, ConstitutiveBatch & batch)
+{
+    Matrix4d E;
+    for (int g = 0; g < (int)curr->shape()->gaussianPt().size(); g++) {
+        MatrixXd B = curr->BMatrix(curr->shape()->gaussianPt(g));
+        VectorXd strain = B * nodeDisp; // e = B * u
+        elasticity.build(curr->modulusAtGaussPt, g, E);
+        VectorXd stress = E * (strain - curr->thermalStrain());
+        batch.set(first + g, curr->material(), stress);
+    }
+}
+
+Nonlinear::Nonlinear(Mesh & meshInfo) : Nonlinear(meshInfo, NULL)
+{
+}
+
+Nonlinear::Nonlinear(Mesh & meshInfo, const Nonlinear* parent)
+  : Analysis(meshInfo),
+    stiffnessSolver(parent != NULL ? parent->stiffnessSolver : StiffnessSolver(mesh)),
+    andersonDepth(std::max((int)mesh.setting("anderson_depth", 0), 0)),
+    anderson(andersonDepth),
+    newton(mesh.settingString("scheme", "secant") == "newton"),
+    newtonTolerance(mesh.setting("newton_tolerance", 1e-6)),
+    newtonIterations((int)mesh.setting("newton_iterations", 30)),
+    adaptiveDamping(mesh.setting("adaptive_damping", 0) != 0),
+    adaptedDamping(-1),
+    previousResidual(-1),
+    searchLine(mesh.setting("line_search", 0) != 0),
+    searchResidual(-1),
+    adaptiveStepping(mesh.setting("adaptive_stepping", 0) != 0),
+    stepIterations((int)mesh.setting("step_iterations", 20)),
+    minStep(mesh.setting("min_step", 0.01)),
+    maxStep(mesh.setting("max_step", 1.0)),
+    predictorOrder(std::min(std::max((int)mesh.setting("predictor", 0), 0), 2)),
+    freezeTolerance(mesh.setting("freeze_tolerance", 0)),
+    freezeIterations(std::max((int)mesh.setting("freeze_iterations", 3), 1)),
+    revalidateInterval(std::max((int)mesh.setting("revalidate_interval", 5), 1)),
+    freezeSweep(0),
+    skippedUpdates(0),
+    threadCount(parent != NULL ? 1 : std::max((int)mesh.setting("threads", 1), 1)), // the load cases are the parallel tasks
+    geostatic(mesh.setting("geostatic", 0) != 0),
+    k0(mesh.setting("k0", 0)),
+    noTension(mesh.setting("no_tension", 0) != 0),
+    tensionTolerance(mesh.setting("tension_tolerance", 1e-3)),
+    tensionIterations(std::max((int)mesh.setting("tension_iterations", 100), 1)),
+    tensionScale(1),
+    tensionResidual(0),
+    checkpointFile(parent != NULL ? "" : mesh.settingString("checkpoint", "")), // the checkpoint belongs to the body force stage
+    checkpoint(mesh),
+    resumePending(false),
+    warmStartDirectory(parent != NULL ? "" : mesh.settingString("warm_start", "")),
+    warmStart(mesh, warmStartDirectory, (int)mesh.setting("warm_start_records", 16), mesh.setting("warm_start_distance", 0.05)),
+    warmStarted(false),
+    coarseMeshFile(parent != NULL ? "" : mesh.settingString("coarse_mesh", "")),
+    seeded(false),
+    totalIterations(0),
+    failed(false),
+    console(parent != NULL ? &caseLog : &std::cout),
+    warning(parent != NULL ? &caseLog : &std::cerr),
+    telemetry(mesh.settingString("telemetry", "")),
+    telemetryIncrement(0),
+    telemetryFactor(0),
+    errorRatio(0)
 {
     gravityIncrementNum = (mesh.iterations)[0];
     loadIncrementNum = (mesh.iterations)[1];
     gravityDamping = (mesh.iterations)[2];
     loadDamping = (mesh.iterations)[3];
+
+    // The checkpoint and the warm start store warn through the warning stream
+    checkpoint.setStream(*warning);
+    warmStart.setStream(*warning);
+
+    // All output of a forked load case, warnings included, goes to its log
+    if (parent != NULL) {
+        stiffnessSolver.setStreams(caseLog, caseLog);
+        condensation.setStream(caseLog);
+        telemetry.setStream(caseLog);
+    }
+
+    // The nonlinear region consists of all DOFs of nonlinear elements; the
+    // remaining DOFs are touched by linear elements only and are condensed
+    condensed = mesh.setting("condensation", 0) != 0;
+    if (condensed) {
+        std::vector<bool> regionDof(2 * mesh.nodeCount(), false);
+        for (int i = 0; i < mesh.elementCount(); i++) {
+            Element* curr = mesh.elementArray()[i];
+            if (curr->material()->nonlinearity) {
+                const VectorXi & nodeList = curr->getNodeList();
+                for (int j = 0; j < curr->getSize(); j++) {
+                    regionDof[2 * nodeList(j)] = true;
+                    regionDof[2 * nodeList(j) + 1] = true;
+                }
+            }
+        }
+        condensation.partition(regionDof);
+    }
+
+    settledIterations.assign(mesh.elementCount(), 0);
+    frozen.assign(mesh.elementCount(), false);
+    fixedDof.assign(2 * mesh.nodeCount(), false);
+    for (auto & dof : mesh.boundaryNodeList)
+        fixedDof[dof] = true;
+
+    if (parent != NULL) {
+        // A forked load case starts from the converged body force stage of the
+        // parent, which has checked the settings and set up the shared materials
+        newton = parent->newton;
+        searchLine = parent->searchLine;
+        nodalDisp = parent->nodalDisp;
+        initialStress = parent->initialStress;
+        totalBodyForce = parent->totalBodyForce;
+        totalThermalStrain = parent->totalThermalStrain;
+        loadIncrementNum = std::max(parent->loadIncrementNum, 1);
+        return;
+    }
+
+    if (searchLine) {
+        for (auto & m : mesh.materialList)
+            if (m->nonlinearity && m->anisotropy) {
+                *warning << "WARNING: Line search supports isotropic models only, it is turned off." << std::endl;
+                searchLine = false;
+                break;
+            }
+    }
+    if (newton) {
+        for (auto & m : mesh.materialList)
+            if (m->nonlinearity && m->anisotropy) {
+                *warning << "WARNING: Newton scheme supports isotropic models only, use secant scheme instead." << std::endl;
+                newton = false;
+            }
+    }
+    // Fast powers in every resilient modulus evaluation of the shared materials
+    if (mesh.setting("fast_math", 0) != 0)
+        for (auto & m : mesh.materialList)
+            m->fastMath = true;
+
+    if (mesh.setting("restart", 0) != 0) {
+        if (checkpointFile.empty())
+            *warning << "WARNING: Restart requires the checkpoint setting, start from the beginning." << std::endl;
+        else
+            resumePending = checkpoint.load(checkpointFile);
+    }
 }
 
 Nonlinear::~Nonlinear()
@@ -37,76 +188,26 @@ void Nonlinear::solve()
 bool incremental = true;
 if (gravityIncrementNum == 0 && loadIncrementNum == 0) incremental = false; // input two zeros means I don't want to have incremental loading
 
+// Seed the moduli from the nearest converged analysis of this mesh
+std::vector<double> features;
+if (!warmStartDirectory.empty()) {
+    features = warmStart.features();
+    if (!resumePending)
+        warmStarted = warmStart.seed(features);
+}
+seeded = warmStarted;
+
+// Multilevel continuation: converge the moduli on the coarse mesh first
+if (!coarseMeshFile.empty() && !seeded && !resumePending)
+    seeded = coarseLevel();
+
 if (incremental) {
     // -----------------------------------------------------------------------------
     // --------------- Start of Incremental Loading Scheme -------------------------
     // -----------------------------------------------------------------------------
 
     // Gravity, temperature, and residual stress increments
-    // Idea: for each material, re-assign the body force, residual stress and
-    // thermal strain incrementally. At the beginning we should calculate the increments
-    // A good observation: with gravity load only, the stress is independent with the modulus,
-    // so any arbitrary initial guess of the modulus won't affect the stress-dependent modulus.
-    const std::vector<Material*> & materials = mesh.materialList;
-    std::vector<Vector2d> gravityIncrement;
-    std::vector<VectorXd> thermalIncrement;
-    gravityIncrement.reserve(materials.size());
-    thermalIncrement.reserve(materials.size());
-
-    // Record the total gravity load
-    for (auto & m : materials) {
-        gravityIncrement.push_back(m->bodyForce() / gravityIncrementNum);
-        thermalIncrement.push_back(m->thermalStrain() / gravityIncrementNum);
-    }
-
-    for (int ic = 1; ic <= gravityIncrementNum; ic++) {
-        // Apply the load incrementally
-        for (unsigned m = 0; m < materials.size(); m++) {
-            materials[m]->setBodyForce(gravityIncrement[m] * ic);
-            materials[m]->setThermalStrain(thermalIncrement[m] * ic);
-            // std::cout << "Debug: " << gravityIncrement[m] * ic << std::endl;
-        }
-
-        // Achieve the modulus and tension convergence at each increment
-        bool nonlinearConvergence = false;
-        int count = 0;
-        while (!nonlinearConvergence) { // convergence criteria
-            // Assemble the K and F based on the mesh information (without applying any
-            // load, this is for body force and temperature load incremental only)
-            // @BUG(solved) Normally applyForce() will initialize the global force vector
-            // and the assembleStiffness() function below will always do += for nodal force. But
-            // in the body force increments, applyForce() is not called, therefore we
-            // need to manually reset the nodalForce otherwise it will keeps accumulating.
-            nodalForce = VectorXd::Zero(2 * mesh.nodeCount());
-            assembleStiffness();
-
-            // Solve K U = F
-            SimplicialLDLT <SparseMatrix<double> > solver;
-            solver.compute(globalStiffness);
-            nodalDisp = solver.solve(nodalForce);
-
-            // Traverse each element, compute stress at Gaussian points, and update the modulus for the next (i + 1) iteration (if current iteration is i)
-            nonlinearConvergence = nonlinearIteration(gravityDamping);
-
-            count++;
-        }
-        // For the exit iteration, the new converged modulus is updated, but the nodalDisp
-        // is for the last iteration, so we should do one more solve to match the modulus & displacment
-        nodalForce = VectorXd::Zero(2 * mesh.nodeCount());
-        assembleStiffness();
-        SimplicialLDLT <SparseMatrix<double> > solver;
-        solver.compute(globalStiffness);
-        nodalDisp = solver.solve(nodalForce);
-
-        std::cout << "Body Force Increment No." << ic << ", Total iterations = " << count << std::endl;
-        // std::cout << "Nodal Displacement: ";
-        // std::cout << std::endl;
-        // for (int i = 0; i < mesh.nodeCount(); i++) {
-        //   std::cout << "Node " << i << " : " << nodalDisp(2 * i) << " " << nodalDisp(2 * i + 1) << std::endl;
-        // }
-        // std::cout << std::endl;
-        std::cout << "-----------------------------------------" << std::endl;
-    }
+    bodyForceStage();
     // std::cout << "Material load applied! \n" << std::endl;
     // For triaxial case: Output the displacment information after the body load but before the surface load
     // std::cout << nodalDisp(2 * 28 + 1) << " " << nodalDisp(2 * 72 + 1) << std::endl;
@@ -115,56 +216,8 @@ if (incremental) {
     // averageStrainAndStress();
     // std::cout << mesh.nodeArray()[28]->getDisp()(1) << " " << mesh.nodeArray()[72]->getDisp()(1) << std::endl;
 
-    // Should note the possible numerical error by dividing the increments, e.g.,
-    // x / 5 * 5 might not be exactly the same number. Actually they are almost the same
-
     // Traffic load increments (point load and edge load)
-    // (Solved) previous @BUG here!
-    // std::vector<double> pointLoadIncrement = mesh.loadValue;
-    // std::vector<std::vector<double> > edgeLoadIncrement = mesh.edgeLoadValue;
-    // pointLoadIncrement, edgeLoadIncrement were not made a reference, so it never affects the real load applied in the iterations!
-    // NO!!! I misunderstood myself...look down below, in the ic-loop, in-place change directly assign values to mesh.loadValue and mesh.edgeLoadValue, so no problem at all!
-    std::vector<double> pointLoadIncrement = mesh.loadValue;
-    std::vector<std::vector<double> > edgeLoadIncrement = mesh.edgeLoadValue;
-    std::transform(pointLoadIncrement.begin(), pointLoadIncrement.end(), pointLoadIncrement.begin(), std::bind(std::multiplies<double>(), std::placeholders::_1, 1.0 / loadIncrementNum)); // in-place change
-    for (auto & e : edgeLoadIncrement)
-        std::transform(e.begin(), e.end(), e.begin(), std::bind(std::multiplies<double>(), std::placeholders::_1, 1.0 / loadIncrementNum));
-
-    for (int ic = 1; ic <= loadIncrementNum; ic++) {
-        // Apply the load incrementally
-        std::transform(pointLoadIncrement.begin(), pointLoadIncrement.end(), mesh.loadValue.begin(), std::bind(std::multiplies<int>(), std::placeholders::_1, ic));
-        for (unsigned e = 0; e < edgeLoadIncrement.size(); e++)
-            std::transform(edgeLoadIncrement[e].begin(), edgeLoadIncrement[e].end(), (mesh.edgeLoadValue)[e].begin(), std::bind(std::multiplies<double>(), std::placeholders::_1, ic));
-
-        // Achieve the modulus and tension convergence at each increment
-        bool nonlinearConvergence = false;
-        int count = 0;
-        while (!nonlinearConvergence) { // convergence criteria
-            // Assemble the K and F based on the mesh information (with traffic load applied)
-            applyForce();
-            assembleStiffness();
-
-            // Solve K U = F
-            SimplicialLDLT <SparseMatrix<double> > solver;
-            solver.compute(globalStiffness);
-            nodalDisp = solver.solve(nodalForce);
-
-            // Traverse each element, compute stress at Gaussian points, and update the modulus for the next (i + 1) iteration (if current iteration is i)
-            nonlinearConvergence = nonlinearIteration(loadDamping);
-
-            count++;
-        }
-        // For the exit iteration, the new converged modulus is updated, but the nodalDisp
-        // is for the last iteration, so we should do one more solve to match the modulus & displacment
-        applyForce();
-        assembleStiffness();
-        SimplicialLDLT <SparseMatrix<double> > solver;
-        solver.compute(globalStiffness);
-        nodalDisp = solver.solve(nodalForce);
-
-        std::cout << "Traffic Load Increment No." << ic << ", Total iterations = " << count << std::endl;
-        std::cout << "-----------------------------------------" << std::endl;
-    }
+    trafficStage();
     // std::cout << "Traffic load applied! \n" << std::endl;
 
     // -----------------------------------------------------------------------------
@@ -176,7 +229,6 @@ else { // experimental module for tension modification (loads are applied direct
     // --------------- Start of Nonlinear Iteration Scheme ---------------------
     // -------------------------------------------------------------------------
     bool nonlinearConvergence = false;
-    int i = 0; // for debug print only
     while (!nonlinearConvergence) { // convergence criteria
     //for (int i = 0; i < 10; i++) {
         // std::cout << "Nonlinear Iteration No." << i++ << std::endl;
@@ -185,18 +237,15 @@ else { // experimental module for tension modification (loads are applied direct
         assembleStiffness();
 
         // Solve K U = F
-        SimplicialLDLT <SparseMatrix<double> > solver;
-        solver.compute(globalStiffness);
-        nodalDisp = solver.solve(nodalForce);
+        solveStiffness();
 
         // Traverse each element, compute stress at Gaussian points, and update the modulus for the next (i + 1) iteration (if current iteration is i)
         nonlinearConvergence = nonlinearIteration(0.3);
+        totalIterations++;
     }
     applyForce();
     assembleStiffness();
-    SimplicialLDLT <SparseMatrix<double> > solver1;
-    solver1.compute(globalStiffness);
-    nodalDisp = solver1.solve(nodalForce);
+    solveStiffness();
     // After convergence is achieved at the last iteration, the solved displacment
     // is stored in the protected member of Analysis class -- nodalDisp. And
     // globalStiffness & nodalForce are also pre-cached. K, U, F are all knowns
@@ -204,43 +253,20 @@ else { // experimental module for tension modification (loads are applied direct
     // -------------------------------------------------------------------------
     // -------------------- End of Nonlinear Scheme ----------------------------
     // -------------------------------------------------------------------------
+}
+    if (failed)
+        return;
+    completeSolution();
 
-    bool tensionScheme = false;
-    if (tensionScheme) {
-    // -------------------------------------------------------------------------
-    // --------------- Start of No Tension Iteration Scheme --------------------
-    // -------------------------------------------------------------------------
-    bool tensionConvergence = false;
-    SimplicialLDLT <SparseMatrix<double> > solver;
-    solver.compute(globalStiffness);
-    i = 0;
-    while (!tensionConvergence) { // convergence criteria
-    // for (int i = 0; i < 2; i++) { // for debug print only
-        // std::cout << "Tension Iteration No." << i++ << std::endl;
-        // Solve K U = F
-        // Note 1: the above nonlinear iteration scheme is iteratively solving a
-        // series of linear elastic cases, where K should be updated every time.
-        // But in the no tension iteration scheme, K remains unchanged as the
-        // last iteration in the nonlinear process. We only update the F vector.
-        // Note 2: in Eigen, the solver.compute() is a pre-conditioning of matrix,
-        // and we can just recycle the solver for current use. Therefore, the
-        // solver is placed outside the while loop.
-        nodalDisp = solver.solve(nodalForce);
-
-        // Traverse each element, compute stress at Gaussian points, and update the modulus for the next (i + 1) iteration (if current iteration is i)
-        tensionConvergence = noTensionIteration();
-        std::cout << "Converge?: " << (tensionConvergence == true ? "Yes" : "No") << std::endl;
-        // Thinking: we can add a check for divergence and stop the no-tension scheme, saying that the mesh/material is not suitable for no-tension modification
+    if (!warmStartDirectory.empty()) {
+        if (warmStarted)
+            *console << "Warm start: distance = " << warmStart.distance() << ", iterations = " << totalIterations << ", saved vs. cold start = " << warmStart.coldIterations() - totalIterations << std::endl;
+        else if (warmStart.distance() >= 0)
+            *console << "Warm start: nearest record at distance " << warmStart.distance() << " is beyond warm_start_distance, iterations = " << totalIterations << std::endl;
+        else
+            *console << "Warm start: no matching record, iterations = " << totalIterations << std::endl;
+        warmStart.record(features, totalIterations);
     }
-    // -------------------------------------------------------------------------
-    // ----------------  End of No Tension Iteration Scheme --------------------
-    // -------------------------------------------------------------------------
-    }
-}
-    // After both material nonlinearity and granular no-tension scheme converge,
-    // compute the nodal strain and stress from the final displacment results
-    computeStrainAndStress();
-    averageStrainAndStress();
 
     // Output the average axial strain at the surface (for fastcell case only)
 //    int node_start = 0, node_end = 38 + 1; // Node 0 ~ 40 are the surface nodes
@@ -254,23 +280,771 @@ else { // experimental module for tension modification (loads are applied direct
 //    std::cout << strain << std::endl;
 }
 
+void Nonlinear::bodyForceStage()
+{
+    // Idea: for each material, re-assign the body force, residual stress and
+    // thermal strain incrementally as a fraction (load factor) of the total load.
+    // A good observation: with gravity load only, the stress is independent with the modulus,
+    // so any arbitrary initial guess of the modulus won't affect the stress-dependent modulus.
+    const std::vector<Material*> & materials = mesh.materialList;
+    totalBodyForce.clear();
+    totalThermalStrain.clear();
+    totalBodyForce.reserve(materials.size());
+    totalThermalStrain.reserve(materials.size());
+
+    // Record the total gravity load
+    for (auto & m : materials) {
+        totalBodyForce.push_back(m->bodyForce());
+        totalThermalStrain.push_back(m->thermalStrain());
+    }
+    if (resumePending && checkpoint.traffic()) {
+        // The checkpoint is past the body force stage
+        applyLoadFactor(false, 1);
+        *console << "Body force stage restored from checkpoint" << std::endl;
+    }
+    else if (seeded) {
+        // The seeded moduli are close to the solution, apply the body force with the traffic load
+        applyLoadFactor(false, 1);
+    }
+    else if (geostatic)
+        geostaticStress();
+    else
+        loadStage(false, gravityIncrementNum, gravityDamping);
+}
+
+void Nonlinear::trafficStage()
+{
+    // Record the total traffic load, the increments directly assign values to
+    // mesh.loadValue and mesh.edgeLoadValue
+    totalPointLoad = mesh.loadValue;
+    totalEdgeLoad = mesh.edgeLoadValue;
+    adaptedDamping = -1; // the traffic stage starts from its own damping ratio
+    loadStage(true, seeded ? 1 : loadIncrementNum, loadDamping);
+}
+
+bool Nonlinear::coarseLevel()
+{
+    Mesh coarse(coarseMeshFile);
+    if (!coarse.nonlinear || coarse.materialList.size() != mesh.materialList.size()) {
+        *warning << "WARNING: Coarse mesh " << coarseMeshFile << " does not have the layers of the mesh, solve on a single level." << std::endl;
+        return false;
+    }
+    // Settings not given for the coarse level are those of the fine level, except
+    // the ones that only apply to the fine run
+    for (auto & setting : mesh.settings)
+        coarse.settings.insert(setting);
+    const char* fineOnly[] = {"coarse_mesh", "checkpoint", "restart", "warm_start", "load_scales", "telemetry"};
+    for (auto & key : fineOnly)
+        coarse.settings.erase(key);
+
+    *console << "> Coarse level: " << coarse.nodeCount() << " nodes, " << coarse.elementCount() << " elements" << std::endl;
+    Nonlinear coarseCase(coarse);
+    coarseCase.console = console;
+    coarseCase.warning = warning;
+    coarseCase.gravityIncrementNum = std::max(coarseCase.gravityIncrementNum, 1);
+    coarseCase.loadIncrementNum = std::max(coarseCase.loadIncrementNum, 1);
+    coarseCase.bodyForceStage();
+    coarseCase.trafficStage();
+
+    // Interpolate the converged moduli at the fine Gaussian points
+    PointLocator locator(coarse);
+    std::vector<MatrixXd> fit(coarse.elementCount()); // nodal values of the fit, computed on first use
+    const std::vector<Material*> & materials = mesh.materialList;
+    int transferred = 0, missed = 0;
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        Element* curr = mesh.elementArray()[i];
+        if (!curr->material()->nonlinearity)
+            continue;
+        int layer = (int)(std::find(materials.begin(), materials.end(), curr->material()) - materials.begin());
+        const MatrixXd & coord = curr->getNodeCoord();
+        for (int g = 0; g < (int)curr->shape()->gaussianPt().size(); g++) {
+            Vector2d point = coord.transpose() * curr->shape()->functionVec(g);
+            int e;
+            Vector2d local;
+            if (!locator.locate(point, layer, e, local)) {
+                missed++;
+                continue;
+            }
+            Element* source = coarse.elementArray()[e];
+            const MatrixXd & modulus = source->modulusAtGaussPt;
+            if (fit[e].size() == 0) {
+                MatrixXd N(source->shape()->gaussianPt().size(), source->getSize());
+                for (int k = 0; k < N.rows(); k++)
+                    N.row(k) = source->shape()->functionVec(k).transpose();
+                fit[e] = N.colPivHouseholderQr().solve(modulus);
+            }
+            RowVectorXd value = source->shape()->functionVec(local).transpose() * fit[e];
+            value = value.cwiseMax(modulus.colwise().minCoeff()).cwiseMin(modulus.colwise().maxCoeff());
+            if (value.size() == curr->modulusAtGaussPt.cols()) {
+                curr->modulusAtGaussPt.row(g) = value;
+                transferred++;
+            }
+            else
+                missed++;
+        }
+    }
+    *console << "Coarse level iterations = " << coarseCase.totalIterations << ", moduli transferred to " << transferred << " Gaussian points";
+    if (missed > 0)
+        *console << " (" << missed << " outside the coarse layers keep the initial guess)";
+    *console << std::endl;
+    *console << "-----------------------------------------" << std::endl;
+    return transferred > 0;
+}
+
+void Nonlinear::completeSolution()
+{
+    // Granular layers cannot take tension: redistribute it at the converged moduli
+    if (noTension)
+        noTensionScheme();
+
+    // After both material nonlinearity and granular no-tension scheme converge,
+    // compute the nodal strain and stress from the final displacment results
+    computeStrainAndStress();
+    averageStrainAndStress();
+}
+
+const bool & Nonlinear::hasFailed() const
+{
+    return failed;
+}
+
+void Nonlinear::solveScenarios(const std::vector<double> & scales, std::string const & baseName)
+{
+    gravityIncrementNum = std::max(gravityIncrementNum, 1);
+    if (resumePending && checkpoint.traffic()) {
+        *warning << "WARNING: The load cases fork the body force stage, the traffic stage checkpoint is not resumed." << std::endl;
+        resumePending = false;
+    }
+    bodyForceStage();
+    if (failed)
+        return;
+
+    // Fork the converged state once per load case. The forks are created
+    // serially, and afterwards each one only touches its own mesh and analysis
+    // (the shared materials are read only in the traffic stage)
+    int caseCount = (int)scales.size();
+    std::vector<Mesh*> forks(caseCount);
+    std::vector<Nonlinear*> cases(caseCount);
+    for (int k = 0; k < caseCount; k++) {
+        forks[k] = new Mesh(mesh);
+        for (auto & p : forks[k]->loadValue)
+            p *= scales[k];
+        for (auto & edge : forks[k]->edgeLoadValue)
+            for (auto & p : edge)
+                p *= scales[k];
+        Nonlinear* child = new Nonlinear(*forks[k], this);
+        if (telemetry.enabled()) {
+            // Each load case streams to its own file, name_caseK.ext
+            std::string name = telemetry.fileName();
+            std::string::size_type dot = name.rfind('.');
+            if (dot == std::string::npos || name.find('/', dot) != std::string::npos)
+                dot = name.size();
+            child->telemetry.setFileName(name.substr(0, dot) + "_case" + std::to_string(k) + name.substr(dot));
+        }
+        cases[k] = child;
+    }
+
+    // Load case k goes to thread k % threads of the worker pool
+    Eigen::initParallel();
+    workers.run(threadCount, caseCount, [&](int k) {
+        cases[k]->trafficStage();
+        if (!cases[k]->failed)
+            cases[k]->completeSolution();
+    });
+
+    for (int k = 0; k < caseCount; k++) {
+        *console << "> Load case " << k << " (scale " << scales[k] << ")" << std::endl;
+        *console << cases[k]->caseLog.str();
+        if (cases[k]->failed)
+            *console << "Load case " << k << " stopped before the full load, no output is written." << std::endl;
+        else
+            cases[k]->writeToVTK(baseName + "_case" + std::to_string(k) + ".vtk");
+        delete cases[k]; cases[k] = NULL;
+        delete forks[k]; forks[k] = NULL;
+    }
+}
+
+void Nonlinear::loadStage(const bool & traffic, const int & incrementNum, const double & damping)
+{
+    if (incrementNum <= 0 || failed)
+        return;
+
+    // Fixed stepping applies the load factors ic / incrementNum; adaptive stepping
+    // starts from 1 / incrementNum and sizes the following steps from the iterations
+    double factor = 0;
+    double step = std::min(std::max(1.0 / incrementNum, minStep), maxStep);
+    int ic = 0;
+    VectorXd savedDisp;
+    std::vector<MatrixXd> savedModulus;
+    double savedDamping = adaptedDamping;
+
+    // Converged increments for the predictor. The traffic stage starts from the
+    // converged body force state, the body force stage from the initial guess
+    std::vector<double> historyFactor;
+    std::vector<VectorXd> historyModulus, historyDisp;
+    if (traffic && nodalDisp.size() == 2 * mesh.nodeCount()) {
+        historyFactor.push_back(0);
+        historyModulus.push_back(gatherModulus());
+        historyDisp.push_back(nodalDisp);
+    }
+
+    // Resume the stage from the converged increment of the checkpoint
+    if (resumePending && checkpoint.traffic() == traffic) {
+        checkpoint.restore(nodalDisp);
+        factor = checkpoint.factor();
+        ic = checkpoint.increment();
+        step = checkpoint.step();
+        adaptedDamping = checkpoint.damping();
+        applyLoadFactor(traffic, factor);
+        historyFactor.assign(1, factor);
+        historyModulus.assign(1, gatherModulus());
+        historyDisp.assign(1, nodalDisp);
+        resumePending = false;
+        *console << (traffic ? "Traffic Load" : "Body Force") << " stage resumed from checkpoint at increment No." << ic << ", load factor = " << factor << std::endl;
+        // Fixed stepping continues with the factor after the checkpoint
+        if (!adaptiveStepping)
+            ic = std::min((int)std::floor(factor * incrementNum + 0.5), incrementNum);
+    }
+
+    while (factor < 1) {
+        double next;
+        if (adaptiveStepping) {
+            next = factor + step;
+            if (next > 1 - 0.5 * minStep) // no sliver step at the end
+                next = 1;
+        }
+        else
+            next = (double)(ic + 1) / incrementNum;
+
+        // Save the converged state of the last increment for a retry or a stop
+        savedDisp = nodalDisp;
+        savedModulus.clear();
+        for (int i = 0; i < mesh.elementCount(); i++)
+            savedModulus.push_back(mesh.elementArray()[i]->modulusAtGaussPt);
+        savedDamping = adaptedDamping;
+
+        // Apply the load incrementally, starting from the extrapolated state
+        applyLoadFactor(traffic, next);
+        if (predictorOrder > 0)
+            predictIncrement(historyFactor, historyModulus, historyDisp, next);
+        bool converged = false;
+        telemetryIncrement = ic + 1;
+        telemetryFactor = next;
+        int count = solveIncrement(traffic, damping, adaptiveStepping ? stepIterations : 0, converged);
+        totalIterations += count;
+
+        // Diverged or over budget: cut the step back and retry from the saved state.
+        // At the minimum step, or with a non-finite state in fixed stepping, restore
+        // the last converged increment and stop there. Only a fixed-step Newton
+        // increment over its iteration limit keeps the last (finite) iteration
+        bool finite = nodalDisp.allFinite();
+        if (!converged && (adaptiveStepping || !finite)) {
+            nodalDisp = savedDisp;
+            for (int i = 0; i < mesh.elementCount(); i++)
+                mesh.elementArray()[i]->modulusAtGaussPt = savedModulus[i];
+            adaptedDamping = savedDamping;
+            if (adaptiveStepping && step > minStep) {
+                step = std::max(0.5 * step, minStep);
+                *console << "Load factor " << next << " not converged in " << count << " iterations, retry with step " << step << std::endl;
+                continue;
+            }
+            *warning << "ERROR: Load factor " << next << (finite ? " not converged at the minimum step" : " diverged")
+                      << ", the analysis stops at the converged load factor " << factor << " of the " << (traffic ? "traffic load" : "body force") << " stage." << std::endl;
+            applyLoadFactor(traffic, factor);
+            failed = true;
+            return;
+        }
+        factor = next;
+        ic++;
+        if (!checkpointFile.empty() && converged) // only a converged increment can be resumed
+            checkpoint.save(checkpointFile, traffic, factor, ic, step, adaptedDamping, nodalDisp);
+        if (predictorOrder > 0) {
+            historyFactor.push_back(factor);
+            historyModulus.push_back(gatherModulus());
+            historyDisp.push_back(nodalDisp);
+            if ((int)historyFactor.size() > predictorOrder + 1) {
+                historyFactor.erase(historyFactor.begin());
+                historyModulus.erase(historyModulus.begin());
+                historyDisp.erase(historyDisp.begin());
+            }
+        }
+
+        *console << (traffic ? "Traffic Load" : "Body Force") << " Increment No." << ic << ", Total iterations = " << count;
+        if (adaptiveStepping)
+            *console << ", load factor = " << factor;
+        *console << std::endl;
+        if (stiffnessSolver.mode() == StiffnessSolver::STALE_PCG)
+            *console << "Factorizations = " << stiffnessSolver.factorizations() << ", PCG iterations = " << stiffnessSolver.iterations() << std::endl;
+        else if (stiffnessSolver.mode() == StiffnessSolver::DEFLATED_CG) {
+            *console << "CG iterations = " << stiffnessSolver.iterations() << " in " << stiffnessSolver.solves() << " solves (first = " << stiffnessSolver.firstIterations() << ", last = " << stiffnessSolver.lastIterations() << ")";
+            if (stiffnessSolver.coldIterations() > 0)
+                *console << ", cold starts = " << stiffnessSolver.coldIterations() << " (saved "
+                         << 100.0 * (stiffnessSolver.coldIterations() - stiffnessSolver.iterations()) / stiffnessSolver.coldIterations() << "%)";
+            if (stiffnessSolver.factorizations() > 0)
+                *console << ", fallback factorizations = " << stiffnessSolver.factorizations();
+            *console << std::endl;
+        }
+        if (stiffnessSolver.mode() != StiffnessSolver::DEFLATED_CG && stiffnessSolver.skyline())
+            *console << "Factor recomputed: last = " << 100 * stiffnessSolver.recomputedFraction() << "%, average = " << 100 * stiffnessSolver.averageRecomputedFraction() << "%" << std::endl;
+        if (andersonDepth > 0)
+            *console << "Anderson mixed steps = " << anderson.mixedSteps() << ", fallback steps = " << anderson.fallbackSteps() << std::endl;
+        if (adaptiveDamping && !newton)
+            *console << "Adapted damping ratio = " << adaptedDamping << std::endl;
+        if (freezeTolerance > 0 && !newton)
+            *console << "Frozen elements = " << std::count(frozen.begin(), frozen.end(), true) << ", skipped element updates = " << skippedUpdates << std::endl;
+        // std::cout << "Nodal Displacement: ";
+        // std::cout << std::endl;
+        // for (int i = 0; i < mesh.nodeCount(); i++) {
+        //   std::cout << "Node " << i << " : " << nodalDisp(2 * i) << " " << nodalDisp(2 * i + 1) << std::endl;
+        // }
+        // std::cout << std::endl;
+        *console << "-----------------------------------------" << std::endl;
+
+        // An easy increment lets the next one grow
+        if (adaptiveStepping && 2 * count <= stepIterations)
+            step = std::min(2 * step, maxStep);
+    }
+}
+
+void Nonlinear::geostaticStress()
+{
+    // Q4/Q8 elements binned by their radial extent, to find those a vertical line cuts through
+    int elementCount = mesh.elementCount();
+    double rMin = HUGE_VAL, rMax = -HUGE_VAL;
+    for (int i = 0; i < elementCount; i++) {
+        const MatrixXd & coord = mesh.elementArray()[i]->getNodeCoord();
+        rMin = std::min(rMin, coord.col(0).minCoeff());
+        rMax = std::max(rMax, coord.col(0).maxCoeff());
+    }
+    int bins = std::max(1, (int)std::sqrt((double)elementCount));
+    double width = rMax > rMin ? (rMax - rMin) / bins : 1;
+    auto bin = [&](const double & r) { return std::min(bins - 1, std::max(0, (int)((r - rMin) / width))); };
+    std::vector<std::vector<int> > binElements(bins);
+    for (int i = 0; i < elementCount; i++) {
+        Element* curr = mesh.elementArray()[i];
+        if (curr->getSize() != 4 && curr->getSize() != 8)
+            continue;
+        const MatrixXd & coord = curr->getNodeCoord();
+        for (int b = bin(coord.col(0).minCoeff()); b <= bin(coord.col(0).maxCoeff()); b++)
+            binElements[b].push_back(i);
+    }
+
+    // Overburden at (r, z): the unit weight integrated along the vertical from z up to the
+    // surface, as the sum over the chords the vertical cuts through the corner polygons of the
+    // elements above. The half-open test a_r <= r < b_r counts a shared vertical edge once
+    auto overburden = [&](const double & r, const double & z) {
+        double sigmaZ = 0;
+        for (auto & i : binElements[bin(r)]) {
+            Element* curr = mesh.elementArray()[i];
+            const MatrixXd & coord = curr->getNodeCoord();
+            double low = HUGE_VAL, high = -HUGE_VAL;
+            for (int j = 0; j < 4; j++) {
+                int k = (j + 1) % 4;
+                if ((coord(j, 0) <= r) == (coord(k, 0) <= r))
+                    continue;
+                double crossing = coord(j, 1) + (r - coord(j, 0)) * (coord(k, 1) - coord(j, 1)) / (coord(k, 0) - coord(j, 0));
+                low = std::min(low, crossing);
+                high = std::max(high, crossing);
+            }
+            if (high > z)
+                sigmaZ += curr->material()->bodyForce()(1) * (high - std::max(low, z));
+        }
+        return sigmaZ;
+    };
+
+    int initialized = 0;
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        Element* curr = mesh.elementArray()[i];
+        Material* material = curr->material();
+        if (!material->nonlinearity)
+            continue;
+        const MatrixXd & coord = curr->getNodeCoord();
+        for (int g = 0; g < (int)curr->shape()->gaussianPt().size(); g++) {
+            // Overburden along the vertical through the Gaussian point (compression negative)
+            double r = curr->shape()->functionVec(g).dot(coord.col(0));
+            double z = curr->shape()->functionVec(g).dot(coord.col(1));
+            double sigmaZ = overburden(r, z);
+
+            double ratio = k0;
+            if (ratio <= 0) {
+                MatrixXd E = curr->EMatrix((curr->modulusAtGaussPt).row(g));
+                ratio = E(0, 2) / E(2, 2);
+            }
+            double sigmaR = ratio * sigmaZ;
+            Vector3d principal;
+            ConstitutiveBatch::principalStress(sigmaR, sigmaR, sigmaZ, 0, principal(0), principal(1), principal(2));
+            VectorXd modulus = material->stressDependentModulus(principal);
+
+            // Keep the initial guess where the model gives no usable modulus (e.g. zero overburden)
+            if (!material->anisotropy) {
+                if (std::isfinite(modulus(1)) && modulus(1) > 0) {
+                    (curr->modulusAtGaussPt)(g) = modulus(1);
+                    initialized++;
+                }
+            }
+            else if (modulus.allFinite() && (modulus.array() > 0).all()) {
+                (curr->modulusAtGaussPt).row(g) = modulus.transpose();
+                initialized++;
+            }
+        }
+    }
+
+    // Displacement under the full body force and thermal strain with these moduli
+    staleElement.clear();
+    nodalForce = VectorXd::Zero(2 * mesh.nodeCount());
+    assembleStiffness();
+    solveStiffness();
+    *console << "Geostatic stress initialized at " << initialized << " Gaussian points, K0 = ";
+    if (k0 > 0)
+        *console << k0 << std::endl;
+    else
+        *console << "at-rest value of each layer" << std::endl;
+    *console << "-----------------------------------------" << std::endl;
+}
+
+void Nonlinear::applyLoadFactor(const bool & traffic, const double & factor)
+{
+    if (traffic) {
+        std::transform(totalPointLoad.begin(), totalPointLoad.end(), mesh.loadValue.begin(), std::bind(std::multiplies<double>(), std::placeholders::_1, factor));
+        for (unsigned e = 0; e < totalEdgeLoad.size(); e++)
+            std::transform(totalEdgeLoad[e].begin(), totalEdgeLoad[e].end(), (mesh.edgeLoadValue)[e].begin(), std::bind(std::multiplies<double>(), std::placeholders::_1, factor));
+    }
+    else {
+        const std::vector<Material*> & materials = mesh.materialList;
+        for (unsigned m = 0; m < materials.size(); m++) {
+            materials[m]->setBodyForce(totalBodyForce[m] * factor);
+            materials[m]->setThermalStrain(totalThermalStrain[m] * factor);
+        }
+    }
+}
+
+int Nonlinear::solveIncrement(const bool & traffic, const double & damping, const int & maxIterations, bool & converged)
+{
+    // Achieve the modulus and tension convergence at each increment
+    int count = 0;
+    anderson.reset();
+    previousResidual = -1;
+    searchResidual = -1;
+    staleElement.clear(); // the load has changed, assemble all elements
+    freezeSweep = 0; // and update all elements at the first iteration
+    skippedUpdates = 0;
+    if (newton)
+        return newtonSolve(traffic, maxIterations > 0 ? std::min(maxIterations, newtonIterations) : newtonIterations, converged);
+
+    converged = false;
+    Telemetry::Record record;
+    std::chrono::steady_clock::time_point start, assembled, solved;
+    double factorTime = 0;
+    while (!converged) { // convergence criteria
+        if (telemetry.enabled()) {
+            start = std::chrono::steady_clock::now();
+            factorTime = stiffnessSolver.factorTime();
+        }
+        if (traffic) {
+            // Assemble the K and F based on the mesh information (with traffic load applied)
+            applyForce();
+        }
+        else {
+            // Assemble the K and F based on the mesh information (without applying any
+            // load, this is for body force and temperature load incremental only)
+            // @BUG(solved) Normally applyForce() will initialize the global force vector
+            // and the assembleStiffness() function below will always do += for nodal force. But
+            // in the body force increments, applyForce() is not called, therefore we
+            // need to manually reset the nodalForce otherwise it will keeps accumulating.
+            nodalForce = VectorXd::Zero(2 * mesh.nodeCount());
+        }
+        if (searchLine) {
+            // The products with the last system for the line search, before the assembly replaces it
+            searchLoad = nodalForce;
+            if (searchResidual >= 0)
+                searchCross = globalStiffness * nodalDisp;
+        }
+        assembleStiffness();
+        if (searchLine)
+            lineSearch();
+        if (telemetry.enabled())
+            assembled = std::chrono::steady_clock::now();
+
+        // Solve K U = F
+        solveStiffness();
+        if (telemetry.enabled())
+            solved = std::chrono::steady_clock::now();
+
+        // Traverse each element, compute stress at Gaussian points, and update the modulus for the next (i + 1) iteration (if current iteration is i)
+        converged = nonlinearIteration(damping);
+
+        count++;
+
+        if (telemetry.enabled()) {
+            std::chrono::steady_clock::time_point updated = std::chrono::steady_clock::now();
+            record.stage = traffic ? "traffic" : "body";
+            record.increment = telemetryIncrement;
+            record.iteration = count;
+            record.loadFactor = telemetryFactor;
+            record.errorRatio = errorRatio;
+            iterationStatistics(damping, record);
+            record.assembly = std::chrono::duration<double, std::milli>(assembled - start).count();
+            record.factor = stiffnessSolver.factorTime() - factorTime;
+            record.solve = std::chrono::duration<double, std::milli>(solved - assembled).count() - record.factor;
+            record.update = std::chrono::duration<double, std::milli>(updated - solved).count();
+            telemetry.write(record);
+        }
+
+        // Give up when the displacement blows up, or when the iteration budget is spent
+        if (!converged && (!nodalDisp.allFinite() || (maxIterations > 0 && count >= maxIterations)))
+            return count;
+    }
+    // For the exit iteration, the new converged modulus is updated, but the nodalDisp
+    // is for the last iteration, so we should do one more solve to match the modulus & displacment
+    if (traffic)
+        applyForce();
+    else
+        nodalForce = VectorXd::Zero(2 * mesh.nodeCount());
+    assembleStiffness();
+    solveStiffness();
+    return count;
+}
+
+void Nonlinear::solveStiffness()
+{
+    if (condensed)
+        condensation.solve(globalStiffness, nodalForce, nodalDisp, stiffnessSolver);
+    else
+        stiffnessSolver.solve(globalStiffness, nodalForce, nodalDisp);
+}
+
+int Nonlinear::newtonSolve(const bool & traffic, const int & maxIterations, bool & converged)
+{
+    if (nodalDisp.size() != 2 * mesh.nodeCount())
+        nodalDisp = VectorXd::Zero(2 * mesh.nodeCount());
+
+    std::vector<Triplet<double> > correction;
+    SparseLU<SparseMatrix<double> > tangentSolver;
+    bool analyzed = false;
+    int count = 0;
+
+    // Telemetry of the Newton iterations: the residual ratio, no modulus statistics
+    Telemetry::Record record;
+    record.stage = traffic ? "traffic" : "body";
+    record.increment = telemetryIncrement;
+    record.loadFactor = telemetryFactor;
+    record.maxChange = 0;
+    record.maxElement = record.maxPoint = -1;
+    record.unconverged = 0;
+    record.factor = record.solve = 0;
+    std::chrono::steady_clock::time_point start, updated, assembled;
+    while (true) {
+        if (telemetry.enabled())
+            start = std::chrono::steady_clock::now();
+        // Moduli consistent with the current displacement, then the secant
+        // stiffness and the force vector with these moduli
+        consistentModulus(correction);
+        if (telemetry.enabled())
+            updated = std::chrono::steady_clock::now();
+        if (traffic)
+            applyForce();
+        else
+            nodalForce = VectorXd::Zero(2 * mesh.nodeCount());
+        assembleStiffness();
+        if (telemetry.enabled()) {
+            assembled = std::chrono::steady_clock::now();
+            record.update = std::chrono::duration<double, std::milli>(updated - start).count();
+            record.assembly = std::chrono::duration<double, std::milli>(assembled - updated).count();
+        }
+
+        // R = F - K(M) U is the external force minus the internal force (the
+        // thermal part of the internal force is in F)
+        VectorXd residual = nodalForce - globalStiffness * nodalDisp;
+        double normF = nodalForce.norm();
+        double ratio = normF > 0 ? residual.norm() / normF : residual.norm();
+        *console << "Newton iteration " << count << ": |R|/|F| = " << ratio << std::endl;
+        record.iteration = count + 1;
+        record.errorRatio = ratio;
+        converged = ratio < newtonTolerance;
+        if (converged || count >= maxIterations || !std::isfinite(ratio)) {
+            if (telemetry.enabled()) {
+                record.factor = record.solve = 0;
+                telemetry.write(record);
+            }
+            if (!converged)
+                *warning << "WARNING: Newton scheme did not converge in " << count << " iterations." << std::endl;
+            break;
+        }
+
+        // The consistent tangent is nonsymmetric, K_t = K(M) + sum B^T s dM/de^T B
+        SparseMatrix<double> tangent(globalStiffness.rows(), globalStiffness.cols());
+        tangent.setFromTriplets(correction.begin(), correction.end());
+        tangent += globalStiffness;
+        if (!analyzed) {
+            tangentSolver.analyzePattern(tangent);
+            analyzed = true;
+        }
+        tangentSolver.factorize(tangent);
+        std::chrono::steady_clock::time_point factorized;
+        double factorTime = stiffnessSolver.factorTime();
+        if (telemetry.enabled())
+            factorized = std::chrono::steady_clock::now();
+        if (tangentSolver.info() != Success) {
+            *warning << "WARNING: Singular tangent stiffness, use secant stiffness instead." << std::endl;
+            VectorXd delta = VectorXd::Zero(residual.size());
+            stiffnessSolver.solve(globalStiffness, residual, delta);
+            nodalDisp += delta;
+        }
+        else
+            nodalDisp += tangentSolver.solve(residual);
+        if (telemetry.enabled()) {
+            double fallback = stiffnessSolver.factorTime() - factorTime; // secant factorization of a singular tangent
+            record.factor = std::chrono::duration<double, std::milli>(factorized - assembled).count() + fallback;
+            record.solve = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - factorized).count() - fallback;
+            telemetry.write(record);
+        }
+        count++;
+    }
+    return count;
+}
+
+void Nonlinear::consistentModulus(std::vector<Triplet<double> > & correction)
+{
+    correction.clear();
+    VectorXd unit = VectorXd::Ones(1);
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        Element* curr = mesh.elementArray()[i];
+        Material* material = curr->material();
+        if (!material->nonlinearity)
+            continue;
+        const VectorXi & nodeList = curr->getNodeList();
+        int numNodes = curr->getSize();
+        int numGaussianPt = (int)curr->shape()->gaussianPt().size();
+        VectorXd nodeDisp(2 * numNodes);
+        for (int j = 0; j < numNodes; j++) {
+            nodeDisp(2 * j) = nodalDisp(2 * nodeList(j));
+            nodeDisp(2 * j + 1) = nodalDisp(2 * nodeList(j) + 1);
+        }
+        MatrixXd unitE = material->EMatrix(unit);
+        MatrixXd localCorrection = MatrixXd::Zero(2 * numNodes, 2 * numNodes);
+
+        for (int g = 0; g < numGaussianPt; g++) {
+            const Vector2d & point = curr->shape()->gaussianPt(g);
+            MatrixXd B = curr->BMatrix(point);
+            VectorXd s = unitE * (B * nodeDisp - curr->thermalStrain()); // stress per unit modulus
+            if (s.isZero(0))
+                continue; // no strain yet, keep the initial guess modulus and the secant stiffness
+
+            // Local Newton solve of the scalar equation M = f(M * s)
+            double M = (curr->modulusAtGaussPt)(g);
+            double slope = 1;
+            bool solved = false;
+            for (int it = 0; it < 50; it++) {
+                VectorXd stress = M * s;
+                double f = material->stressDependentModulus(principalStress(stress))(1);
+                slope = 1 - material->modulusGradient(stress).dot(s);
+                double step = (M - f) / slope;
+                if (!std::isfinite(step) || slope <= 0) // non-monotonic, take the fixed-point value
+                    step = M - f;
+                double next = M - step;
+                while (next <= 0 && step > 0) { // keep the modulus positive
+                    step /= 2;
+                    next = M - step;
+                }
+                solved = std::abs(next - M) <= 1e-10 * std::abs(next);
+                M = next;
+                if (solved)
+                    break;
+            }
+            (curr->modulusAtGaussPt)(g) = M;
+            slope = 1 - material->modulusGradient(M * s).dot(s);
+            if (!solved || slope <= 0)
+                continue; // secant stiffness at this point
+
+            // dM/de = M * E(1) * df/dsigma / (1 - df/dsigma . s)
+            VectorXd dMde = M * unitE.transpose() * material->modulusGradient(M * s) / slope;
+            double weight = 2 * M_PI * curr->jacobian(point).determinant() * curr->radius(point) * curr->shape()->gaussianWt(g);
+            localCorrection += weight * (B.transpose() * s) * (B.transpose() * dMde).transpose();
+        }
+
+        // Scatter, the rows and columns with boundary conditions are crossed out as in assembleStiffness()
+        for (int a = 0; a < 2 * numNodes; a++) {
+            int row = 2 * nodeList(a / 2) + a % 2;
+            if (fixedDof[row])
+                continue;
+            for (int b = 0; b < 2 * numNodes; b++) {
+                int col = 2 * nodeList(b / 2) + b % 2;
+                if (!fixedDof[col] && localCorrection(a, b) != 0)
+                    correction.push_back(Triplet<double>(row, col, localCorrection(a, b)));
+            }
+        }
+    }
+}
+
 bool Nonlinear::nonlinearIteration(double damping)
 {
     bool convergence = true;
     double sumError = 0;
     double sumModulus = 0;
 
-    Element* curr;
-    int numNodes; // number of nodes belong to the element
-    int numGaussianPt; // number of Gaussian points of the element
-    for (int i = 0; i < mesh.elementCount(); i++) {
-        curr = mesh.elementArray()[i];
+    // Active set: frozen elements are skipped except at the periodic
+    // validation sweeps, where every element is updated
+    bool freezing = freezeTolerance > 0;
+    bool validation = !freezing || freezeSweep % revalidateInterval == 0;
+    freezeSweep++;
+    int skipped = 0;
+    if (freezing)
+        staleElement.assign(mesh.elementCount(), false);
+
+    // Layout of the sweep: the first batch point and the first entry in the
+    // flat modulus buffers of each element, so that elements can be processed
+    // in any order
+    int elementCount = mesh.elementCount();
+    int points = 0, entries = 0;
+    firstPoint.assign(elementCount, -1);
+    firstEntry.assign(elementCount, -1);
+    for (int i = 0; i < elementCount; i++) {
+        Element* curr = mesh.elementArray()[i];
         Material* material = curr->material();
-        if (material->nonlinearity) { // compute stress for nonlinear elastic element only, skip all linear elastic ones
-            const VectorXi & nodeList = curr->getNodeList();
-            numNodes = curr->getSize();
-            numGaussianPt = (int)curr->shape()->gaussianPt().size();
+        if (!material->nonlinearity) // compute stress for nonlinear elastic element only, skip all linear elastic ones
+            continue;
+        int numGaussianPt = (int)curr->shape()->gaussianPt().size();
+        firstEntry[i] = entries;
+        entries += numGaussianPt * (material->anisotropy ? 3 : 1);
+        if (validation || !frozen[i]) {
+            firstPoint[i] = points;
+            points += numGaussianPt;
+        }
+    }
+    batch.resize(points);
+    modulusField.resize(entries);
+    modulusTarget.resize(entries);
+    elementChange.assign(elementCount, -1);
+
+    // The elements are swept in chunks of fixed size, each chunk accumulating its
+    // own convergence sums; the sums are combined in chunk order afterwards, so
+    // the result does not depend on the number of threads
+    int chunks = (elementCount + sweepChunk - 1) / sweepChunk;
+    std::vector<double> chunkError(chunks, 0), chunkModulus(chunks, 0);
+    std::vector<char> chunkConvergence(chunks, true);
+
+    // Step 1: Compute stress at gaussian points based on cached M & E from last iteration
+    // Step 2: Update new modulus based on the stress from step 1 and mix with old modulus via damping ratio
+    // Step 3: Cache the modulus to be used in the next iteration
+    // Note: Tutu's approach only use the center Gaussian point for the whole element, as follows
+    // MatrixXd B = curr->BMatrix(curr->shape()->gaussianPt(4));
+    // VectorXd strain = B * nodeDisp; // e = B * u
+    // double modulus_old = (curr->modulusAtGaussPt)(4); // M_(i-1)
+    // VectorXd modulus_old_vec << modulus_old;
+    // VectorXd stress = material->EMatrix(modulus_old_vec) * (strain - curr->thermalStrain()); // sigma = E_(i-1) * (e - e0), note that the M and E are both from previous iteration
+    // VectorXd modulus_vec = material->stressDependentModulus(principalStress(stress));
+    // double modulus_new = modulus_vec(1); // M_i, 1 for vertical modulus
+    // double modulus = (1 - damping) * modulus_old + damping * modulus_new; // true M_i after applying damping ratio
 
+    // Step 1 for all updated elements, the stresses go into the batch
+    parallelChunks(chunks, [&](int c) {
+        for (int i = c * sweepChunk; i < std::min(elementCount, (c + 1) * sweepChunk); i++) {
+            if (firstPoint[i] < 0)
+                continue;
+            Element* curr = mesh.elementArray()[i];
+            Material* material = curr->material();
+            const VectorXi & nodeList = curr->getNodeList();
+            int numNodes = curr->getSize(); // number of nodes belong to the element
             // Assemble the nodal displacement vector for this element
             VectorXd nodeDisp(2 * numNodes);
             for (int j = 0; j < numNodes; j++) {
@@ -278,61 +1052,71 @@ bool Nonlinear::nonlinearIteration(double damping)
                 nodeDisp(2 * j + 1) = nodalDisp(2 * nodeList(j) + 1);
             }
 
-            // Step 1: Compute stress at gaussian points based on cached M & E from last iteration
-            // Step 2: Update new modulus based on the stress from step 1 and mix with old modulus via damping ratio
-            // Step 3: Cache the modulus to be used in the next iteration
-            // Note: Tutu's approach only use the center Gaussian point for the whole element, as follows
-            // MatrixXd B = curr->BMatrix(curr->shape()->gaussianPt(4));
-            // VectorXd strain = B * nodeDisp; // e = B * u
-            // double modulus_old = (curr->modulusAtGaussPt)(4); // M_(i-1)
-            // VectorXd modulus_old_vec << modulus_old;
-            // VectorXd stress = material->EMatrix(modulus_old_vec) * (strain - curr->thermalStrain()); // sigma = E_(i-1) * (e - e0), note that the M and E are both from previous iteration
-            // VectorXd modulus_vec = material->stressDependentModulus(principalStress(stress));
-            // double modulus_new = modulus_vec(1); // M_i, 1 for vertical modulus
-            // double modulus = (1 - damping) * modulus_old + damping * modulus_new; // true M_i after applying damping ratio
+            // The E matrix builder is picked once for the element
+            if (material->anisotropy)
+                setPointStress(curr, CrossAnisotropicElasticity(*material), nodeDisp, firstPoint[i], batch);
+            else
+                setPointStress(curr, IsotropicElasticity(*material), nodeDisp, firstPoint[i], batch);
+        }
+    });
+
+    // Principal stresses (closed form) and stress-dependent moduli of all Gaussian points
+    // tension modification would clip the principal stresses here:
+    // if (principal(x) > 0) principal(x) = 0;
+    int pointChunks = (points + batchChunk - 1) / batchChunk;
+    parallelChunks(pointChunks, [&](int c) {
+        batch.evaluate(c * batchChunk, std::min(points, (c + 1) * batchChunk));
+    });
+
+    // Step 2 & 3, and the convergence sums of each chunk
+    parallelChunks(chunks, [&](int c) {
+        for (int i = c * sweepChunk; i < std::min(elementCount, (c + 1) * sweepChunk); i++) {
+            if (firstEntry[i] < 0)
+                continue;
+            Element* curr = mesh.elementArray()[i];
+            Material* material = curr->material();
+            int numGaussianPt = (int)curr->shape()->gaussianPt().size();
+            int k = firstEntry[i];
+
+            if (firstPoint[i] < 0) {
+                // Frozen element: the moduli are kept, and enter the buffers and the
+                // convergence sums as converged values
+                for (int g = 0; g < numGaussianPt; g++) {
+                    VectorXd modulus_old = (curr->modulusAtGaussPt).row(g);
+                    for (int m = 0; m < modulus_old.size(); m++, k++)
+                        modulusField[k] = modulusTarget[k] = modulus_old(m);
+                    if (g == 4)
+                        chunkModulus[c] += modulus_old.squaredNorm();
+                }
+                continue;
+            }
+            double change = 0; // largest relative change |M_new - M_old| / M_old of the element
 
             // For isotropy case (or a simplified anisotropy case), iterate only on the single modulus (vertical modulus for anisotropy)
             if (!material->anisotropy) {
                 for (int g = 0; g < numGaussianPt; g++) {
-                    // More strict approach
-                    MatrixXd B = curr->BMatrix(curr->shape()->gaussianPt(g));
-                    VectorXd strain = B * nodeDisp; // e = B * u
                     double modulus_old = (curr->modulusAtGaussPt)(g); // M_(i-1)
-                    VectorXd modulus_old_vec(1);
-                    modulus_old_vec << modulus_old;
-                    VectorXd stress = material->EMatrix(modulus_old_vec) * (strain - curr->thermalStrain()); // sigma = E_(i-1) * (e - e0), note that the M and E are both from previous iteration
-                    // tension modification
-                    // VectorXd principal = principalStress(stress);
-                    // for (int x = 0; x < 3; x++) {
-                    //     if (principal(x) > 0) principal(x) = 0;
-                    // }
-                    // VectorXd modulus_vec = material->stressDependentModulus(principal);
-                    // double modulus_new = modulus_vec(1);
-                    VectorXd modulus_vec = material->stressDependentModulus(principalStress(stress));
-                    double modulus_new = modulus_vec(1); // M_i, 1 for vertical modulus
+                    double modulus_new = batch.modulus(firstPoint[i] + g, 1); // M_i, 1 for vertical modulus
                     double modulus = (1 - damping) * modulus_old + damping * modulus_new; // true M_i after applying damping ratio
 
                     (curr->modulusAtGaussPt)(g) = modulus;
+                    change = std::max(change, std::abs(modulus_new - modulus_old) / modulus_old);
+                    modulusField[k] = modulus_old;
+                    modulusTarget[k++] = modulus_new;
 
                     // Convergence criteria
                     // Criteria 1: modulus stabilize within 5% at all Gaussian points (less strict criteria only checks the center Gaussian point)
                     double error = std::abs(modulus - modulus_new);
                     if (g == 4 && error / modulus_old > 0.05) // tutu uses modulus_old, but I want to use modulus
-                        convergence = false;
+                        chunkConvergence[c] = false;
                         // should I just return false? No. Because you want to update all elements' modulus synchronously
                     // Criteraia 2: Accumulative modulus error within 0.2%
                     if (g == 4 /*true*/) { // less strict convergence criteria
-                        sumError += error * error;
-                        sumModulus += modulus_old * modulus_old; // tutu uses modulus_old, but I want to use modulus
+                        chunkError[c] += error * error;
+                        chunkModulus[c] += modulus_old * modulus_old; // tutu uses modulus_old, but I want to use modulus
                     }
                     // For Debug Use
                     if (i == 1 && g == 4) { // the granular element at centerline
-                        // std::cout << "nodelDisp: " << nodeDisp.transpose() << std::endl;
-                        // std::cout << "Strain: " << strain.transpose() << std::endl;
-                        // std::cout << "E: " << material->EMatrix(modulus_old) << std::endl;
-                        // std::cout << "cylindrical stress: " << stress.transpose() << std::endl;
-                        // std::cout << "principal stress: " << principalStress(stress).transpose() << std::endl;
-
                         // std::cout << "Old modulus: " << modulus_old << std::endl;
                         // std::cout << "New modulus: " << modulus_new << std::endl;
                         // std::cout << "True modulus: " << modulus << std::endl;
@@ -342,56 +1126,337 @@ bool Nonlinear::nonlinearIteration(double damping)
             // For anisotropy case, iterate on all 3 moduli (vertical, horizontal, shear modulus)
             else {
                 for (int g = 0; g < numGaussianPt; g++) {
-                    // More strict approach
-                    MatrixXd B = curr->BMatrix(curr->shape()->gaussianPt(g));
-                    VectorXd strain = B * nodeDisp; // e = B * u
                     VectorXd modulus_old = (curr->modulusAtGaussPt).row(g); // M_(i-1)
-                    VectorXd stress = material->EMatrix(modulus_old) * (strain - curr->thermalStrain()); // sigma = E_(i-1) * (e - e0), note that the M and E are both from previous iteration
-                    VectorXd modulus_new = material->stressDependentModulus(principalStress(stress)); // M_i
+                    VectorXd modulus_new(3); // M_i
+                    for (int m = 0; m < 3; m++)
+                        modulus_new(m) = batch.modulus(firstPoint[i] + g, m);
                     VectorXd modulus = (1 - damping) * modulus_old + damping * modulus_new; // true M_i after applying damping ratio
 
                     (curr->modulusAtGaussPt).row(g) = modulus;
+                    change = std::max(change, ((modulus_new - modulus_old).array() / modulus_old.array()).abs().maxCoeff());
+                    for (int m = 0; m < 3; m++, k++) {
+                        modulusField[k] = modulus_old(m);
+                        modulusTarget[k] = modulus_new(m);
+                    }
 
                     // Convergence criteria
                     // Criteria 1: modulus stabilize within 5% at all Gaussian points (less strict criteria only checks the center Gaussian point)
                     VectorXd error = (modulus - modulus_new).array() / modulus_old.array();
                     error = error.array().abs(); // or error.cwiseAbs()
                     if (g == 4 && error(0) > 0.05 && error(1) > 0.05 && error(2) > 0.05) // tutu uses modulus_old, but I want to use modulus
-                        convergence = false;
+                        chunkConvergence[c] = false;
                     // Criteraia 2: Accumulative modulus error within 0.2%
                     error = error.array().square();
                     modulus_old = modulus_old.array().square();
                     if (g == 4/*true*/) { // less strict convergence criteria
-                        sumError += error.sum();
-                        sumModulus += modulus_old.sum(); // tutu uses modulus_old, but I want to use modulus
+                        chunkError[c] += error.sum();
+                        chunkModulus[c] += modulus_old.sum(); // tutu uses modulus_old, but I want to use modulus
                     }
 
                 }
             }
-
+            elementChange[i] = change;
         }
+    });
 
+    for (int c = 0; c < chunks; c++) {
+        sumError += chunkError[c];
+        sumModulus += chunkModulus[c];
+        convergence = convergence && chunkConvergence[c];
+    }
+
+    // An element is frozen after its moduli settled for freezeIterations
+    // updates, and released as soon as a validation sweep sees a change
+    if (freezing) {
+        for (int i = 0; i < elementCount; i++) {
+            if (firstEntry[i] < 0)
+                continue;
+            if (firstPoint[i] < 0) {
+                skipped++;
+                continue;
+            }
+            settledIterations[i] = elementChange[i] < freezeTolerance ? settledIterations[i] + 1 : 0;
+            frozen[i] = settledIterations[i] >= freezeIterations;
+            staleElement[i] = true;
+        }
     }
+    skippedUpdates += skipped;
     // std::cout << "Sum Error: " << sumError / sumModulus << std::endl;
     //std::cout << "Modulus Element No.1: " << mesh.elementArray()[1]->modulusAtGaussPt(1) << std::endl;
-    return (sumError / sumModulus < 0.002 && convergence) ? true : false;
+    errorRatio = sumError / sumModulus;
+    convergence = errorRatio < 0.002 && convergence;
+
+    // Convergence is only accepted if the frozen elements are still settled at
+    // the final displacement; the ones that are not are released
+    if (convergence && skipped > 0) {
+        parallelChunks(chunks, [&](int c) {
+            for (int i = c * sweepChunk; i < std::min(elementCount, (c + 1) * sweepChunk); i++)
+                if (firstEntry[i] >= 0 && firstPoint[i] < 0)
+                    elementChange[i] = modulusChange(mesh.elementArray()[i]);
+        });
+        for (int i = 0; i < elementCount; i++) {
+            if (firstEntry[i] >= 0 && firstPoint[i] < 0 && elementChange[i] >= freezeTolerance) {
+                frozen[i] = false;
+                settledIterations[i] = 0;
+                convergence = false;
+            }
+        }
+    }
 
+    // The damped moduli are already in place; replace them by the Anderson
+    // mixing of the last iterates and/or the adapted damping if the scheme
+    // goes on. The convergence check above always uses the given damping, so
+    // the acceptance criteria do not depend on the adapted ratio
+    if (!convergence && !modulusField.empty() && (adaptiveDamping || andersonDepth > 0)) {
+        Map<VectorXd> field(modulusField.data(), modulusField.size());
+        Map<VectorXd> target(modulusTarget.data(), modulusTarget.size());
+        double ratio = damping;
+        if (adaptiveDamping) {
+            if (adaptedDamping < 0)
+                adaptedDamping = damping;
+            ratio = adaptDamping(errorRatio);
+        }
+        scatterModulus(anderson.update(field, target, ratio));
+        if (freezing) // the mixing may move every modulus
+            for (int i = 0; i < mesh.elementCount(); i++)
+                staleElement[i] = staleElement[i] || mesh.elementArray()[i]->material()->nonlinearity;
+    }
+    return convergence;
 }
 
-bool Nonlinear::noTensionIteration()
+void Nonlinear::parallelChunks(const int & count, const std::function<void(int)> & task)
 {
-    bool convergence = true;
+    // Static round-robin assignment of the chunks to the threads of the pool. The
+    // pool always gets threadCount threads, so a sweep with fewer chunks than threads
+    // leaves the surplus workers idle instead of restarting the pool
+    workers.run(threadCount, count, task);
+}
+
+void Nonlinear::iterationStatistics(const double & damping, Telemetry::Record & record) const
+{
+    // The buffers hold the old and the target moduli of every nonlinear element
+    // (frozen ones with the two equal), so the damped error is (1 - damping) times the change
+    record.maxChange = 0;
+    record.maxElement = record.maxPoint = -1;
+    record.unconverged = 0;
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        if (firstEntry[i] < 0)
+            continue;
+        Element* curr = mesh.elementArray()[i];
+        int moduli = curr->material()->anisotropy ? 3 : 1;
+        int numGaussianPt = (int)curr->shape()->gaussianPt().size();
+        for (int g = 0; g < numGaussianPt; g++) {
+            double change = 0;
+            for (int m = 0; m < moduli; m++) {
+                int k = firstEntry[i] + g * moduli + m;
+                change = std::max(change, std::abs(modulusTarget[k] - modulusField[k]) / modulusField[k]);
+            }
+            if (change > record.maxChange) {
+                record.maxChange = change;
+                record.maxElement = i;
+                record.maxPoint = g;
+            }
+            if ((1 - damping) * change > 0.05)
+                record.unconverged++;
+        }
+    }
+}
+
+double Nonlinear::modulusChange(Element* curr) const
+{
+    Material* material = curr->material();
+    const VectorXi & nodeList = curr->getNodeList();
+    int numNodes = curr->getSize();
+    int numGaussianPt = (int)curr->shape()->gaussianPt().size();
+    VectorXd nodeDisp(2 * numNodes);
+    for (int j = 0; j < numNodes; j++) {
+        nodeDisp(2 * j) = nodalDisp(2 * nodeList(j));
+        nodeDisp(2 * j + 1) = nodalDisp(2 * nodeList(j) + 1);
+    }
+
+    double change = 0;
+    for (int g = 0; g < numGaussianPt; g++) {
+        VectorXd strain = curr->BMatrix(curr->shape()->gaussianPt(g)) * nodeDisp;
+        VectorXd modulus_old = (curr->modulusAtGaussPt).row(g);
+        VectorXd stress = material->EMatrix(modulus_old) * (strain - curr->thermalStrain());
+        VectorXd modulus_new = material->stressDependentModulus(principalStress(stress));
+        if (!material->anisotropy)
+            change = std::max(change, std::abs(modulus_new(1) - modulus_old(0)) / modulus_old(0));
+        else
+            change = std::max(change, ((modulus_new - modulus_old).array() / modulus_old.array()).abs().maxCoeff());
+    }
+    return change;
+}
+
+double Nonlinear::adaptDamping(const double & residual)
+{
+    if (previousResidual > 0) {
+        double contraction = residual / previousResidual;
+        if (contraction > 1) // the iteration oscillates or diverges
+            adaptedDamping = std::max(0.5 * adaptedDamping, 0.05);
+        else if (contraction < 0.9) // contracts steadily, take longer steps
+            adaptedDamping = std::min(1.5 * adaptedDamping, 0.9);
+    }
+    previousResidual = residual;
+    return adaptedDamping;
+}
+
+void Nonlinear::lineSearch()
+{
+    // Zero the fixed DOFs of a residual
+    auto freeNorm = [&](VectorXd r) {
+        for (int d = 0; d < (int)r.size(); d++)
+            if (fixedDof[d])
+                r(d) = 0;
+        return r.norm();
+    };
+    if (nodalDisp.size() != nodalForce.size()) {
+        searchResidual = -1;
+        return;
+    }
+
+    // The moduli were just updated from the current displacement, so K U
+    // with the assembled K is its internal force with its own moduli
+    VectorXd modulus = gatherModulus();
+    VectorXd internal = globalStiffness * nodalDisp;
+    double residual = freeNorm(nodalForce - internal);
+    if (searchResidual >= 0 && residual > searchResidual && searchDisp.size() == nodalDisp.size()
+        && searchModulus.size() == modulus.size() && searchCross.size() == nodalDisp.size()) {
+        // The last update raised the residual, backtrack on the interpolated secant system
+        // K(a) = (1 - a) Kp + a K between the last iteration and this one, with
+        // U(a) = Up + a (U - Up). K(a) U(a) only needs the products Kp Up, Kp U (kept
+        // from the last iteration and before this assembly), K Up and K U
+        VectorXd current = globalStiffness * searchDisp;
+        double alpha = 1;
+        for (double trial = 0.5; trial >= 0.25; trial /= 2) {
+            VectorXd force = (1 - trial) * searchForce + trial * nodalForce;
+            VectorXd last = (1 - trial) * searchInternal + trial * searchCross;
+            VectorXd next = (1 - trial) * current + trial * internal;
+            double r = freeNorm(force - (1 - trial) * last - trial * next);
+            if (r < residual) {
+                residual = r;
+                alpha = trial;
+            }
+        }
+        if (alpha < 1) {
+            // K is linear in the moduli of isotropic layers, so reassembling the
+            // nonlinear elements from the interpolated moduli gives K(alpha)
+            nodalDisp = searchDisp + alpha * (nodalDisp - searchDisp);
+            scatterModulus((1 - alpha) * searchModulus + alpha * modulus);
+            if (!staleElement.empty())
+                for (int i = 0; i < mesh.elementCount(); i++)
+                    staleElement[i] = staleElement[i] || mesh.elementArray()[i]->material()->nonlinearity;
+            nodalForce = searchLoad;
+            assembleStiffness();
+            modulus = gatherModulus();
+            internal = globalStiffness * nodalDisp;
+            residual = freeNorm(nodalForce - internal);
+        }
+    }
+    searchForce = nodalForce;
+    searchInternal = internal;
+    searchModulus = modulus;
+    searchDisp = nodalDisp;
+    searchResidual = residual;
+}
+
+void Nonlinear::scatterModulus(const VectorXd & modulus)
+{
+    int k = 0;
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        Element* curr = mesh.elementArray()[i];
+        Material* material = curr->material();
+        if (material->nonlinearity) {
+            int numGaussianPt = (int)curr->shape()->gaussianPt().size();
+            for (int g = 0; g < numGaussianPt; g++) {
+                if (!material->anisotropy)
+                    (curr->modulusAtGaussPt)(g) = modulus(k++);
+                else
+                    for (int c = 0; c < 3; c++)
+                        (curr->modulusAtGaussPt)(g, c) = modulus(k++);
+            }
+        }
+    }
+}
 
-    Element* curr;
-    int numNodes; // number of nodes belong to the element
-    int numGaussianPt; // number of Gaussian points of the element
+VectorXd Nonlinear::gatherModulus() const
+{
+    std::vector<double> modulus;
     for (int i = 0; i < mesh.elementCount(); i++) {
-        curr = mesh.elementArray()[i];
+        Element* curr = mesh.elementArray()[i];
         Material* material = curr->material();
-        if (material->noTension) { // compute stress for no tension granular elements only, skip all HMA/subgrade ones
+        if (material->nonlinearity) {
+            int numGaussianPt = (int)curr->shape()->gaussianPt().size();
+            for (int g = 0; g < numGaussianPt; g++) {
+                if (!material->anisotropy)
+                    modulus.push_back((curr->modulusAtGaussPt)(g));
+                else
+                    for (int c = 0; c < 3; c++)
+                        modulus.push_back((curr->modulusAtGaussPt)(g, c));
+            }
+        }
+    }
+    return Map<VectorXd>(modulus.data(), modulus.size());
+}
+
+void Nonlinear::predictIncrement(const std::vector<double> & factors, const std::vector<VectorXd> & moduli, const std::vector<VectorXd> & disps, const double & next)
+{
+    int size = (int)factors.size();
+    int n = std::min(size, predictorOrder + 1);
+    if (n < 2)
+        return;
+
+    // Lagrange interpolation through the last n converged increments, evaluated at the next load factor
+    VectorXd modulus = VectorXd::Zero(moduli.back().size());
+    VectorXd disp = VectorXd::Zero(disps.back().size());
+    for (int a = size - n; a < size; a++) {
+        double weight = 1;
+        for (int b = size - n; b < size; b++)
+            if (b != a)
+                weight *= (next - factors[b]) / (factors[a] - factors[b]);
+        modulus += weight * moduli[a];
+        disp += weight * disps[a];
+    }
+
+    // Outliers are clamped to within a factor of 2 of the last converged modulus, which keeps them positive
+    const VectorXd & last = moduli.back();
+    scatterModulus(modulus.cwiseMax(0.5 * last).cwiseMin(2 * last));
+    nodalDisp = disp;
+}
+
+bool Nonlinear::noTensionIteration()
+{
+    // Step 1: Compute stress at gaussian points based on the solved nodal displacement, less the tension removed so far
+    // Step 2: Filter out the tensile principal stresses in a batch (closed form, see ConstitutiveBatch) and rotate them back
+    // Step 3: The removed tension accumulates in the initial stress, and its nodal force int B^T t dV in the tension load
+    int elementCount = mesh.elementCount();
+    int chunks = (elementCount + sweepChunk - 1) / sweepChunk;
+    std::vector<VectorXd> elementForce(elementCount);
+
+    // The Gauss points of each chunk are contiguous in the batch
+    std::vector<int> chunkPoint(chunks + 1, 0);
+    firstPoint.assign(elementCount, -1);
+    int points = 0;
+    for (int i = 0; i < elementCount; i++) {
+        if (i % sweepChunk == 0)
+            chunkPoint[i / sweepChunk] = points;
+        if (initialStress[i].size() == 0)
+            continue;
+        firstPoint[i] = points;
+        points += (int)initialStress[i].cols();
+    }
+    chunkPoint[chunks] = points;
+    batch.resize(points);
+
+    parallelChunks(chunks, [&](int c) {
+        int last = std::min(elementCount, (c + 1) * sweepChunk);
+        for (int i = c * sweepChunk; i < last; i++) {
+            if (firstPoint[i] < 0)
+                continue;
+            Element* curr = mesh.elementArray()[i];
             const VectorXi & nodeList = curr->getNodeList();
-            numNodes = curr->getSize();
-            numGaussianPt = (int)curr->shape()->gaussianPt().size();
+            int numNodes = curr->getSize();
+            int numGaussianPt = (int)curr->shape()->gaussianPt().size();
 
             // Assemble the nodal displacement vector for this element
             VectorXd nodeDisp(2 * numNodes);
@@ -399,79 +1464,107 @@ bool Nonlinear::noTensionIteration()
                 nodeDisp(2 * j) = nodalDisp(2 * nodeList(j));
                 nodeDisp(2 * j + 1) = nodalDisp(2 * nodeList(j) + 1);
             }
-
-            // Step 1: Compute stress at gaussian points based on the solved nodal displacement from last iteration
-            // Step 2: Compute principal stress and rotation angle based on the stress (sigma r, sigma theta, sigma z, tau rz), and filter out the tensile components based on the limiting tensile strength critera 0.1.
-            // Step 3: Counteract the global load vector based on the tensionForce and output the boolean convergence.
-            MatrixXd tension(4, numGaussianPt);
             for (int g = 0; g < numGaussianPt; g++) {
-                MatrixXd B = curr->BMatrix(curr->shape()->gaussianPt(g));
-                VectorXd strain = B * nodeDisp; // e = B * u
-                double modulus = (curr->modulusAtGaussPt)(g);
-                VectorXd modulus_vec(1);
-                modulus_vec << modulus;
-                VectorXd stress = material->EMatrix(modulus_vec) * (strain - curr->thermalStrain()); // sigma = E_(i-1) * (e - e0), note that the M and E are both from previous iteration
-
-                // Compute principal stress and rotation angle
-                // p1 = (s1 + s3) / 2 + radius;
-                // p3 = (s1 + s3) / 2 - radius;
-                // p2 = s2;
-                // tan(2*theta) = -2 * tau / (s1 - s3)
-                double radius = std::sqrt( (stress(0) - stress(2)) * (stress(0) - stress(2)) / 4 + stress(3) * stress(3) ); // sqrt{ [(s1 - s3)/2]^2 + tau^2 }
-                double sigma1 = (stress(0) + stress(2)) / 2 + radius;
-                double sigma2 = stress(1);
-                double sigma3 = (stress(0) + stress(2)) / 2 - radius;
-                double theta = std::atan2(-2 * stress(3), stress(0) - stress(2)) / 2;
-                // Or use the eigen approach:
-                // VectorXd principal = principalStress(stress);
-                // double sigma1 = principal(2);
-                // double sigma2 = principal(1);
-                // double sigma3 = principal(0);
-                // double theta = std::atan2(-2 * stress(3), stress(0) - stress(2)) / 2;
-
-                // In our FEM routine, + is tension, - is compression
-                double limit = 0.0;
-                if (g == 4 && (sigma1 > limit || sigma2 > limit || sigma3 > limit)) // only check at center Gaussian point, otherwise the solution will diverge
-                    convergence = false;
-
-                double t1 = sigma1 > limit ? sigma1 : 0;
-                double t2 = sigma2 > limit ? sigma2 : 0;
-                double t3 = sigma3 > limit ? sigma3 : 0;
-                // Principal stress -> Polar stress -> Counteract force
-                double sigma_r = (t1 + t3) / 2 + (t1 - t3) * std::cos(2 * theta) / 2;
-                double sigma_t = t2;
-                double sigma_z = (t1 + t3) / 2 - (t1 - t3) * std::cos(2 * theta) / 2;
-                double tau_rz = (t1 - t3) * std::sin(2 * theta) / 2;
-                VectorXd tensionStress(4);
-                tensionStress << sigma_r, sigma_t, sigma_z, tau_rz;
-                tension.col(g) = tensionStress;
-
-                if (i == 107 && g == 1) { // the granular element at centerline
-                    for (int mm = 0; mm < numNodes; mm++)
-                        std::cout << " NodalForce "<< mm <<": "<< nodalForce(2*nodeList(mm)) <<" "<<nodalForce(2*nodeList(mm)+1) << std::endl;
-                }
+                VectorXd strain = curr->BMatrix(curr->shape()->gaussianPt(g)) * nodeDisp; // e = B * u
+                VectorXd stress = curr->EMatrix((curr->modulusAtGaussPt).row(g)) * (strain - curr->thermalStrain()) - initialStress[i].col(g);
+                batch.set(firstPoint[i] + g, curr->material(), stress);
             }
-            VectorXd tensionForce = curr->computeTensionForce(tension);
+        }
 
-            // Assemble the element tension force to global nodal force
-            for (int k = 0; k < numNodes; k++) {
-                nodalForce(2 * nodeList(k)) += tensionForce(2 * k);
-                nodalForce(2 * nodeList(k) + 1) += tensionForce(2 * k + 1);
-            }
+        // In our FEM routine, + is tension, - is compression
+        batch.tension(chunkPoint[c], chunkPoint[c + 1]);
+
+        for (int i = c * sweepChunk; i < last; i++) {
+            if (firstPoint[i] < 0)
+                continue;
+            Element* curr = mesh.elementArray()[i];
+            int numGaussianPt = (int)initialStress[i].cols();
+            MatrixXd tension(4, numGaussianPt);
+            for (int g = 0; g < numGaussianPt; g++)
+                for (int m = 0; m < 4; m++)
+                    tension(m, g) = batch.stress(firstPoint[i] + g, m);
+            initialStress[i] += tension;
+            elementForce[i] = curr->computeTensionForce(tension);
+        }
+    });
+
+    // Assemble the element tension forces in element order, so the result does not depend on the threads
+    VectorXd force = VectorXd::Zero(2 * mesh.nodeCount());
+    for (int i = 0; i < elementCount; i++) {
+        if (elementForce[i].size() == 0)
+            continue;
+        const VectorXi & nodeList = mesh.elementArray()[i]->getNodeList();
+        for (int k = 0; k < (int)nodeList.size(); k++) {
+            force(2 * nodeList(k)) += elementForce[i](2 * k);
+            force(2 * nodeList(k) + 1) += elementForce[i](2 * k + 1);
         }
     }
-    return convergence;
+    for (int d = 0; d < (int)force.size(); d++)
+        if (fixedDof[d])
+            force(d) = 0;
+    tensionLoad += force;
+
+    // Converged when the force of the tension removed in this iteration is negligible
+    tensionResidual = force.norm() / tensionScale;
+    return tensionResidual <= tensionTolerance;
+}
+
+void Nonlinear::noTensionScheme()
+{
+    // The moduli stay at their converged values, so K is factorized once and
+    // every iteration only solves with the updated load F + int B^T sigma0 dV
+    initialStress.assign(mesh.elementCount(), MatrixXd());
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        Element* curr = mesh.elementArray()[i];
+        if (curr->material()->noTension && !curr->material()->geosynthetic)
+            initialStress[i] = MatrixXd::Zero(4, curr->shape()->gaussianPt().size());
+    }
+    staleElement.clear();
+    applyForce();
+    assembleStiffness();
+    VectorXd externalForce = nodalForce;
+    for (int d = 0; d < (int)externalForce.size(); d++)
+        if (fixedDof[d])
+            externalForce(d) = 0;
+    tensionScale = std::max(externalForce.norm(), 1e-300);
+    tensionLoad = VectorXd::Zero(nodalForce.size());
+
+    // The configured solver (factorization, condensation) holds one factorization of K for all iterations
+    VectorXd force = nodalForce;
+    stiffnessSolver.reset();
+    stiffnessSolver.hold(true);
+    bool converged = false;
+    int count = 0;
+    while (!converged && count < tensionIterations) {
+        nodalForce = force + tensionLoad;
+        solveStiffness();
+        converged = noTensionIteration();
+        count++;
+    }
+    nodalForce = force + tensionLoad;
+    solveStiffness();
+    nodalForce = force;
+    stiffnessSolver.hold(false);
+    if (!converged)
+        *warning << "WARNING: No-tension scheme not converged in " << count << " iterations, residual = " << tensionResidual << std::endl;
+    *console << "No-tension iterations = " << count << ", residual = " << tensionResidual << std::endl;
+    *console << "-----------------------------------------" << std::endl;
 }
 
 VectorXd Nonlinear::principalStress(const VectorXd & stress) const
 {
     // In our coordinates, vertical stress: -:compression +:tension; Horizontal stress: -:compression +:tension
-    MatrixXd tensor(3,3);
-    tensor << stress(0), 0, stress(3),
-              0, stress(1), 0,
-              stress(3), 0, stress(2);
-    SelfAdjointEigenSolver<MatrixXd> es(tensor, EigenvaluesOnly);
-    return es.eigenvalues();
+    // The axisymmetric tensor is block diagonal, so the eigenvalues are in closed form
+    // (see ConstitutiveBatch) rather than from SelfAdjointEigenSolver as before:
+    // MatrixXd tensor(3,3);
+    // tensor << stress(0), 0, stress(3),
+    //           0, stress(1), 0,
+    //           stress(3), 0, stress(2);
+    // SelfAdjointEigenSolver<MatrixXd> es(tensor, EigenvaluesOnly);
+    // return es.eigenvalues();
+    VectorXd result(3);
+    ConstitutiveBatch::principalStress(stress(0), stress(1), stress(2), stress(3), result(0), result(1), result(2));
+    return result;
 
     // Tutu's approach
     // VectorXd result(3);
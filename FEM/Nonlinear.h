@@ -17,6 +17,19 @@
 #define Nonlinear_h
 
 #include "Analysis.h"
+#include "StiffnessSolver.h"
+#include "StaticCondensation.h"
+#include "AndersonMixing.h"
+#include "ConstitutiveBatch.h"
+#include "Checkpoint.h"
+#include "WarmStart.h"
+#include "Telemetry.h"
+#include "WorkerPool.h"
+#include <vector>
+#include <functional>
+#include <string>
+#include <iostream>
+#include <sstream>
 
 /* Derived class for solving nonlinear elastic problems.
  */
@@ -37,9 +50,12 @@ class Nonlinear : public Analysis
     bool nonlinearIteration(double damping);
 
     /**
-     * Compute unbalanced tension stresses at Gaussian points, and update the nodal force vector for next iterations.
+     * Compute unbalanced tension stresses at Gaussian points of no-tension
+     * elements, add them to the initial stress, and add their nodal force to
+     * the tension load for the next iteration (initial-stress method).
      *
-     * @return A boolean value incidating the convergence status at this iteration.
+     * @return A boolean value incidating the convergence status at this iteration,
+     * i.e. whether the force of the removed tension is within the tolerance of the load.
      */
     bool noTensionIteration();
 
@@ -51,11 +67,336 @@ class Nonlinear : public Analysis
      */
     VectorXd principalStress(const VectorXd & stress) const;
 
+    /**
+     * Solve several traffic load cases from one converged body force stage.
+     * The body force stage runs once on this analysis; each load case then
+     * forks the mesh (nodes, elements and Gaussian-point moduli are copied,
+     * materials are shared) and runs its own traffic stage from the forked
+     * state. The load cases run concurrently on the "threads" setting, their
+     * progress output is printed in order once all of them finish, and each
+     * result is written to baseName_caseK.vtk.
+     *
+     * @param scales The factor of the input point and edge loads of each load case.
+     * @param baseName The base name of the output VTK files.
+     */
+    void solveScenarios(const std::vector<double> & scales, std::string const & baseName);
+
+    /**
+     * Check if the analysis stopped before the full load, i.e. an increment did
+     * not converge at the minimum step or diverged. The displacement and the
+     * moduli are then those of the last converged increment.
+     *
+     * @return True if the analysis stopped.
+     */
+    const bool & hasFailed() const;
+
   private:
+    /**
+     * Fork constructor of a load case of solveScenarios(). The case starts
+     * from the converged body force stage of the parent and takes its solver
+     * settings. It skips what belongs to the parent analysis (restart,
+     * checkpoint, warm start, coarse level, setup of the shared materials), runs
+     * on one thread, and writes all its output to caseLog.
+     *
+     * @param meshInfo The mesh of the load case, a copy of the parent's with scaled loads.
+     * @param parent The parent analysis, NULL for a normal analysis.
+     */
+    Nonlinear(Mesh & meshInfo, const Nonlinear* parent);
+
     int gravityIncrementNum; /* No. of body load (gravity & temperature & residual) increments */
     int loadIncrementNum; /* No. of traffic load (point & edge) increments */
     double gravityDamping; /* Damping ratio lambda for body force incremental loading */
     double loadDamping; /* Damping ratio lambda for traffic incremental loading */
+    StiffnessSolver stiffnessSolver; /* Solver for K U = F, direct, stale-factorization PCG or deflated CG ("solver" setting) */
+    bool condensed; /* Whether the linear layers are condensed onto the nonlinear region ("condensation" setting) */
+    StaticCondensation condensation; /* Schur complement substructuring of the linear interior */
+    int andersonDepth; /* Number of stored differences of the Anderson acceleration ("anderson_depth" setting, 0 for plain damping) */
+    AndersonMixing anderson; /* Anderson acceleration of the modulus iteration, reset at each increment */
+    std::vector<double> modulusField; /* Flat buffer of the Gauss-point moduli of nonlinear elements at the current iteration */
+    std::vector<double> modulusTarget; /* Flat buffer of the stress-dependent moduli computed from them */
+    ConstitutiveBatch batch; /* Structure-of-arrays Gauss-point stresses and moduli of the updated elements */
+    std::vector<int> firstPoint; /* Index of the first Gauss point of each element in the batch, -1 if not updated */
+    std::vector<int> firstEntry; /* Index of the first entry of each element in the flat modulus buffers, -1 for linear elements */
+    std::vector<double> elementChange; /* Largest relative modulus change of each updated element in the sweep */
+
+    bool newton; /* Whether the Newton-Raphson scheme with consistent tangent is used ("scheme" setting, "secant" or "newton") */
+    double newtonTolerance; /* Relative residual tolerance |R|/|F| of the Newton scheme */
+    int newtonIterations; /* Maximum Newton iterations per increment */
+    std::vector<bool> fixedDof; /* Whether each DOF has a boundary condition */
+
+    /**
+     * Solve the current load increment by the Newton-Raphson scheme on the
+     * force residual R = F - K(M) U, where the Gauss-point moduli M are always
+     * consistent with the displacement (M = f(M * E(1) * e)) and the tangent
+     * includes the derivative of the modulus with respect to the strain.
+     *
+     * @param traffic True if the traffic load is applied (applyForce), false for body force increments.
+     * @param maxIterations The maximum number of Newton iterations.
+     * @param converged Set to whether the residual tolerance is reached.
+     * @return The number of Newton iterations.
+     */
+    int newtonSolve(const bool & traffic, const int & maxIterations, bool & converged);
+
+    /**
+     * Update the moduli of nonlinear elements to be consistent with the current
+     * displacement, and compute the consistent tangent correction
+     * sum 2PI * B^T * (s * dM/de^T) * B * |J| * r * W at all Gaussian points,
+     * where s = E(1) * (e - e0) is the stress per unit modulus.
+     *
+     * @param correction The triplets of the tangent correction to the secant stiffness.
+     */
+    void consistentModulus(std::vector<Triplet<double> > & correction);
+
+    bool adaptiveDamping; /* Whether the damping ratio is adapted per iteration ("adaptive_damping" setting) */
+    double adaptedDamping; /* The adapted damping ratio, negative before the first iteration of a loading stage */
+    double previousResidual; /* Modulus error ratio sumError / sumModulus of the previous iteration, negative at the start of an increment */
+    bool searchLine; /* Whether the secant update is line searched on the equilibrium residual ("line_search" setting) */
+    VectorXd searchForce; /* Assembled force vector of the last iteration, for the line search */
+    VectorXd searchInternal; /* Internal force Kp Up of the last iteration's system and displacement */
+    VectorXd searchCross; /* Kp U, the last system times the current displacement, taken before the assembly */
+    VectorXd searchLoad; /* Force vector before the element contributions are assembled */
+    VectorXd searchModulus; /* Gauss-point moduli of the last iteration */
+    VectorXd searchDisp; /* Displacement the last iteration started from */
+    double searchResidual; /* Equilibrium residual |F - K U| of the last iteration, negative at the start of an increment */
+
+    /**
+     * Adapt the damping ratio from the contraction of the modulus error ratio
+     * sumError / sumModulus (the convergence measure, also reported as the
+     * telemetry error ratio) between two iterations: increase it while the
+     * iteration contracts fast, decrease it when the error grows (oscillation).
+     *
+     * @param residual The modulus error ratio of this iteration.
+     * @return The damping ratio to be used for this update.
+     */
+    double adaptDamping(const double & residual);
+
+    /**
+     * Backtracking line search on the secant iteration, called after each
+     * assembly. The residual |F - K U| of the assembled system is that of the
+     * current displacement with the moduli updated from it, so no constitutive
+     * update is repeated. If it grew since the last iteration, the system,
+     * moduli and displacement are moved back to (1 - alpha) times the last
+     * ones plus alpha times the current ones, alpha = 1/2, 1/4, whichever
+     * interpolated residual is the smallest. The trial residuals only need
+     * four matrix-vector products, so no matrix is stored; an accepted step
+     * reassembles the nonlinear elements from the interpolated moduli. K is
+     * linear in the moduli of isotropic layers only, so the line search is
+     * turned off for cross-anisotropic nonlinear layers.
+     */
+    void lineSearch();
+
+    /**
+     * Overwrite the Gauss-point moduli of nonlinear elements from a flat
+     * buffer ordered as modulusField.
+     *
+     * @param modulus The flat modulus buffer.
+     */
+    void scatterModulus(const VectorXd & modulus);
+
+    /**
+     * Solve K U = F for the nodal displacement, either directly or by static
+     * condensation of the linear interior.
+     */
+    void solveStiffness();
+
+    bool adaptiveStepping; /* Whether the load increments are sized automatically ("adaptive_stepping" setting) */
+    int stepIterations; /* Iteration budget per increment, an increment exceeding it is cut back ("step_iterations" setting) */
+    double minStep; /* Smallest load factor increment ("min_step" setting) */
+    double maxStep; /* Largest load factor increment ("max_step" setting) */
+    std::vector<Vector2d> totalBodyForce; /* Total body force of each material */
+    std::vector<VectorXd> totalThermalStrain; /* Total thermal strain of each material */
+    std::vector<double> totalPointLoad; /* Total point loads */
+    std::vector<std::vector<double> > totalEdgeLoad; /* Total edge loads */
+
+    /**
+     * Apply a loading stage (body force or traffic load) in increments of the
+     * load factor. With fixed stepping the factors are ic / incrementNum. With
+     * adaptive stepping the first increment is 1 / incrementNum; an increment
+     * that converges within half of the iteration budget doubles the next
+     * one, and an increment that exceeds the budget is restored to the last
+     * converged state and retried with half the step, within [minStep, maxStep].
+     *
+     * @param traffic True for the traffic load stage, false for the body force stage.
+     * @param incrementNum The number of increments (fixed) or the initial step 1 / incrementNum (adaptive).
+     * @param damping The damping ratio of the modulus iteration.
+     */
+    void loadStage(const bool & traffic, const int & incrementNum, const double & damping);
+
+    /**
+     * Scale the recorded total loads of a stage by the load factor.
+     *
+     * @param traffic True for the point and edge loads, false for the body force and thermal strain.
+     * @param factor The load factor in (0, 1].
+     */
+    void applyLoadFactor(const bool & traffic, const double & factor);
+
+    /**
+     * Achieve the modulus convergence at the current load, by the secant or the Newton scheme.
+     *
+     * @param traffic True if the traffic load is applied (applyForce), false for body force increments.
+     * @param damping The damping ratio of the secant scheme.
+     * @param maxIterations The iteration budget, 0 to iterate until convergence.
+     * @param converged Set to whether the increment converged within the budget.
+     * @return The number of iterations.
+     */
+    int solveIncrement(const bool & traffic, const double & damping, const int & maxIterations, bool & converged);
+
+    int predictorOrder; /* Order of the extrapolation in load factor before each increment ("predictor" setting, 0 off, 1 linear, 2 quadratic) */
+
+    /**
+     * Gather the Gauss-point moduli of nonlinear elements into a flat buffer
+     * ordered as modulusField.
+     *
+     * @return The flat modulus buffer.
+     */
+    VectorXd gatherModulus() const;
+
+    /**
+     * Predict the moduli and displacement at the next load factor by
+     * extrapolating the last converged increments, linearly or quadratically
+     * in load factor. The predicted moduli are clamped to [1/2, 2] times the
+     * last converged moduli. Nothing is done with less than two increments.
+     *
+     * @param factors The load factors of the converged increments.
+     * @param moduli The flat moduli of the converged increments.
+     * @param disps The nodal displacements of the converged increments.
+     * @param next The load factor of the next increment.
+     */
+    void predictIncrement(const std::vector<double> & factors, const std::vector<VectorXd> & moduli, const std::vector<VectorXd> & disps, const double & next);
+
+    // Active set of the secant scheme: an element whose largest relative modulus
+    // change stays below freezeTolerance for freezeIterations updates is frozen,
+    // i.e. its constitutive update and its local stiffness are skipped. Every
+    // revalidateInterval iterations, and at the first iteration of an increment,
+    // all elements are updated again. Before convergence is accepted the frozen
+    // elements are checked at the final displacement.
+    double freezeTolerance; /* Relative modulus change below which an element settles ("freeze_tolerance" setting, 0 to disable) */
+    int freezeIterations; /* Number of settled updates before an element is frozen ("freeze_iterations" setting) */
+    int revalidateInterval; /* Number of iterations between validation sweeps ("revalidate_interval" setting) */
+    std::vector<int> settledIterations; /* Number of consecutive settled updates of each element */
+    std::vector<bool> frozen; /* Whether each element is frozen */
+    int freezeSweep; /* Iterations since the start of the increment */
+    int skippedUpdates; /* Number of skipped element updates in the increment */
+
+    /**
+     * Compute the largest relative change |M_new - M_old| / M_old over the
+     * Gaussian points of an element, where M_new is the stress-dependent
+     * modulus at the current displacement. The moduli are not modified.
+     *
+     * @param curr The nonlinear element.
+     * @return The largest relative modulus change.
+     */
+    double modulusChange(Element* curr) const;
+
+    int threadCount; /* Number of threads of the Gauss-point sweep ("threads" setting) */
+    WorkerPool workers; /* Threads of the sweeps, started at the first parallel sweep and kept for the analysis */
+
+    /**
+     * Run task(c) for c = 0, ..., count - 1 on threadCount threads of the
+     * worker pool. Chunk c goes to thread c % threadCount, and the tasks must
+     * write disjoint data.
+     *
+     * @param count The number of chunks.
+     * @param task The work of one chunk.
+     */
+    void parallelChunks(const int & count, const std::function<void(int)> & task);
+
+    bool geostatic; /* Whether the body force stage is replaced by the geostatic stress field ("geostatic" setting) */
+    double k0; /* Lateral earth pressure coefficient sigma_r / sigma_z ("k0" setting), non-positive for the at-rest value of each layer */
+
+    /**
+     * Initialize the moduli of nonlinear elements from the geostatic stress
+     * field instead of the body force increments. The vertical stress at a
+     * Gaussian point is the overburden sigma_z = integral of the unit weight
+     * along the vertical from the point up to the surface, summed over the
+     * elements the vertical cuts through (so lateral zones and repeated layers
+     * count where they are), and sigma_r = sigma_theta = K0 sigma_z, tau_rz = 0. Without a "k0" setting,
+     * K0 = E(0,2) / E(2,2) of the element, i.e. nu / (1 - nu) for isotropic
+     * layers, the lateral stress of a laterally confined elastic layer. The
+     * moduli are evaluated from this stress, and one linear solve under the
+     * full body force and thermal strain gives the matching displacement.
+     */
+    void geostaticStress();
+
+    bool noTension; /* Whether the tension of no-tension layers is redistributed after the modulus convergence ("no_tension" setting) */
+    double tensionTolerance; /* Relative force of the tension removed per iteration below which the scheme stops ("tension_tolerance" setting) */
+    int tensionIterations; /* Maximum no-tension iterations ("tension_iterations" setting) */
+    VectorXd tensionLoad; /* Accumulated nodal force int B^T sigma0 dV of the initial stress */
+    double tensionScale; /* Norm of the external load over the free DOFs */
+    double tensionResidual; /* Relative force of the tension removed in the last iteration */
+
+    /**
+     * Redistribute the tension of no-tension elements by the initial-stress
+     * method: K stays at the converged moduli and is factorized once, and each
+     * iteration solves K U = F + int B^T sigma0 dV and moves the tensile part of
+     * the stress into sigma0 (Analysis::initialStress), which is subtracted
+     * from the output stresses.
+     */
+    void noTensionScheme();
+
+    std::string checkpointFile; /* Checkpoint written after each converged increment ("checkpoint" setting, empty to disable) */
+    Checkpoint checkpoint; /* Checkpoint of the incremental scheme */
+    bool resumePending; /* Whether the checkpoint was loaded ("restart" setting) and is not resumed yet */
+
+    std::string warmStartDirectory; /* Directory of the warm start store ("warm_start" setting, empty to disable) */
+    WarmStart warmStart; /* Store of converged modulus fields of the mesh, used within "warm_start_distance" of the features */
+    bool warmStarted; /* Whether the moduli were seeded from the store */
+    std::string coarseMeshFile; /* Input file of the coarse level ("coarse_mesh" setting, empty for a single level) */
+    bool seeded; /* Whether the moduli were seeded (warm start or coarse level), then both loads are applied in one increment */
+    int totalIterations; /* Modulus iterations of the analysis */
+    bool failed; /* Whether an increment failed and the analysis stopped at the last converged increment */
+
+    std::ostream* console; /* Stream of the progress output, std::cout or the log of a forked load case */
+    std::ostream* warning; /* Stream of the warnings, std::cerr or the log of a forked load case */
+    std::ostringstream caseLog; /* Progress and warning output of a forked load case */
+
+    Telemetry telemetry; /* Per-iteration convergence records ("telemetry" setting, empty to disable) */
+    int telemetryIncrement; /* Increment No. of the iterations being recorded */
+    double telemetryFactor; /* Load factor of the iterations being recorded */
+    double errorRatio; /* sumError / sumModulus of the last modulus iteration */
+
+    /**
+     * Fill the modulus statistics of a telemetry record from the buffers of
+     * the last modulus iteration: the largest relative change with its element
+     * and Gaussian point, and the number of Gaussian points whose damped
+     * modulus is still off the target by more than 5%.
+     *
+     * @param damping The damping ratio of the iteration.
+     * @param record The record to be filled.
+     */
+    void iterationStatistics(const double & damping, Telemetry::Record & record) const;
+
+    /**
+     * Body force stage of the incremental scheme: record the total body force
+     * and thermal strain, and apply them incrementally (or as the geostatic
+     * stress field).
+     */
+    void bodyForceStage();
+
+    /**
+     * Traffic stage of the incremental scheme: record the total point and edge
+     * loads, and apply them incrementally from the current state.
+     */
+    void trafficStage();
+
+    /**
+     * Solve the nonlinear problem on the coarse mesh and interpolate its
+     * converged Gauss-point moduli to the Gaussian points of this mesh. Each
+     * fine Gaussian point is located in a coarse element of the same layer
+     * (PointLocator), where the modulus is the least-squares fit of the
+     * coarse Gauss-point moduli in the shape functions, bounded by the
+     * extremes of those moduli. The coarse level uses the settings of its
+     * input file, falling back to those of this mesh.
+     *
+     * @return Whether any modulus was transferred.
+     */
+    bool coarseLevel();
+
+    /**
+     * Final steps after the modulus convergence: the no-tension scheme if set,
+     * and the nodal strain and stress.
+     */
+    void completeSolution();
 
 };
 
@@ -7,11 +7,17 @@
  */
 
 #include "NonlinearElastic.h"
+#include "Elasticity.h"
 #include <cmath>
 #include <iostream>
+#include <algorithm>
+#include <vector>
 NonlinearElastic::NonlinearElastic(const bool & anisotropy, const bool & nonlinearity, const bool & noTension, const bool & geosynthetic, const std::vector<double> & properties, const int & model, const std::vector<double> & parameters)
-  : Material(anisotropy, nonlinearity, noTension, geosynthetic), modelNo(model), coeff(parameters)
+  : Material(anisotropy, nonlinearity, noTension, geosynthetic), modelNo(model), coeff(parameters), resilientModel(ResilientModelRegistry::find(model))
 {
+    if (resilientModel == NULL)
+        std::cerr << "WARNING: Resilient model " << modelNo << " is not registered, the stress-dependent modulus is set to zero." << std::endl;
+
     // Just copy from LinearElastic constructor
     int i = 0;
     if (!anisotropy) { // Isotropic: Modulus, Poisson's ratio, body force (r,z), thermal coefficient, temperature change
@@ -60,116 +66,103 @@ NonlinearElastic::~NonlinearElastic()
 {
 }
 
+std::vector<double> NonlinearElastic::parameters() const
+{
+    std::vector<double> list = Material::parameters();
+    list.push_back(modelNo);
+    list.insert(list.end(), coeff.begin(), coeff.end());
+    return list;
+}
+
+int NonlinearElastic::model() const
+{
+    return modelNo;
+}
+
 VectorXd NonlinearElastic::stressDependentModulus(const VectorXd & stress) const
 {
-    // stress(0)-sigma3; stress(1)-sigma2; stress(2)-sigma1
+    // stress(0)-sigma3; stress(1)-sigma2; stress(2)-sigma1, a batch of one point
+    VectorXd result(3); // horizontal modulus, vertical modulus, shear modulus
+    stressDependentModulus(1, &stress(0), &stress(1), &stress(2), &result(0), &result(1), &result(2));
+    return result;
+}
+
+void NonlinearElastic::stressDependentModulus(const int & n, const double* sigma3, const double* sigma2, const double* sigma1, double* Mr, double* Mz, double* G) const
+{
     // Bulk stress: theta = sigma1 + sigma2 + sigma3
     // Deviatoric stress: sigma_d = sigma1 - sigma3
     // Octahedral shear stress (usually meaningful in 3D): tau_oct = sqrt((1-2)^2 + (2-3)^2 + (1-3)^2) / 3, for 2D := sqrt(2)/3 * sigma_d
-    double bulk = std::abs( stress(2) + stress(1) + stress(0) );
-    double deviator = std::abs( stress(2) - stress(0) );
-    double octahedral = std::sqrt(std::pow(stress(2) - stress(1), 2) + std::pow(stress(1) - stress(0), 2) + std::pow(stress(2) - stress(0), 2)) / 3;
-    double atm = 14.696; // atmospheric pressure, 101.325 kPa or 14.7 psi
-
-    // Calculated new stress-dependent resilient modulus from different models
-    double Mr = 0, Mz = 0, G = 0; // horizontal modulus, vertical modulus, shear modulus
-    switch (modelNo) {
-        case 1 :
-            // Hicks and Monismith (1971) K-theta model
-            // M = k1 * theta^k2
-            if (!anisotropy) {
-                Mz = coeff[0] * std::pow(bulk, coeff[1]);
-            } else {
-                Mr = coeff[0] * std::pow(bulk, coeff[1]); // although K-theta only has 2 parameters, we fill 0 to complement the triplet
-                Mz = coeff[3] * std::pow(bulk, coeff[4]);
-                G = coeff[6] * std::pow(bulk, coeff[7]);
-            }
-            break;
-        case 2 :
-            // Uzan (1985) model:
-            // M = k1 * theta^k2 * sigma_d^k3
-            if (!anisotropy) {
-                Mz = coeff[0] * std::pow(bulk, coeff[1]) * std::pow(deviator, coeff[2]);
-            } else {
-                Mr = coeff[0] * std::pow(bulk, coeff[1]) * std::pow(deviator, coeff[2]);
-                Mz = coeff[3] * std::pow(bulk, coeff[4]) * std::pow(deviator, coeff[5]);
-                G = coeff[6] * std::pow(bulk, coeff[7]) * std::pow(deviator, coeff[8]);
-            }
-            break;
-        case 3 :
-            /*
-            // Pezo (1993) UT-Austin model (deprecated)
-            // M = k1 * sigma_d^k2 * sigma_3^k3
-            if (!anisotropy) {
-                Mz = coeff[0] * std::pow(deviator, coeff[1]) * std::pow(std::abs(stress(0)), coeff[2]);
-            } else {
-                Mr = coeff[0] * std::pow(deviator, coeff[1]) * std::pow(std::abs(stress(0)), coeff[2]);
-                Mz = coeff[3] * std::pow(deviator, coeff[4]) * std::pow(std::abs(stress(0)), coeff[5]);
-                G = coeff[6] * std::pow(deviator, coeff[7]) * std::pow(std::abs(stress(0)), coeff[8]);
-            }
-            break;
-            */
-            // Witczak and Uzan (1988) Universal model
-            // M = k1 * p_a * (theta/p_a)^k2 * (tau_oct/p_a)^k3
-            if (!anisotropy) {
-                Mz = coeff[0] * atm * std::pow(bulk/atm, coeff[1]) * std::pow(octahedral/atm, coeff[2]);
-            } else {
-                Mr = coeff[0] * atm * std::pow(bulk/atm, coeff[1]) * std::pow(octahedral/atm, coeff[2]);
-                Mz = coeff[3] * atm * std::pow(bulk/atm, coeff[4]) * std::pow(octahedral/atm, coeff[5]);
-                G = coeff[6] * atm * std::pow(bulk/atm, coeff[7]) * std::pow(octahedral/atm, coeff[8]);
-            }
-            break;
-        case 4 :
-            // NCHRP 1-37A (2004) MEPDG model
-            // M = k1 * p_a * (theta/p_a)^k2 * (tau_oct/p_a + 1)^k3
-            if (!anisotropy) {
-                Mz = coeff[0] * atm * std::pow(bulk/atm, coeff[1]) * std::pow(octahedral/atm + 1, coeff[2]);
-            } else {
-                Mr = coeff[0] * atm * std::pow(bulk/atm, coeff[1]) * std::pow(octahedral/atm + 1, coeff[2]);
-                Mz = coeff[3] * atm * std::pow(bulk/atm, coeff[4]) * std::pow(octahedral/atm + 1, coeff[5]);
-                G = coeff[6] * atm * std::pow(bulk/atm, coeff[7]) * std::pow(octahedral/atm + 1, coeff[8]);
-            }
-            break;
-        case 5 :
-            // Thompson and Robnett (1979) Bilinear model (subgrade)
-            // M = k1 - k * (sigma_d - k2)
-            // k = k3 when sigma_d <= k2, k = k4 when sigma_d >= k2
-            if (!anisotropy) {
-                double k = deviator < coeff[1] ? coeff[2] : coeff[3];
-                Mz = coeff[0] - k * (deviator - coeff[1]);
-            } else {
-                double kr = deviator < coeff[1] ? coeff[2] : coeff[3];
-                double kz = deviator < coeff[5] ? coeff[6] : coeff[7];
-                double kg = deviator < coeff[9] ? coeff[10] : coeff[11];
-                Mr = coeff[0] - kr * (deviator - coeff[1]);
-                Mz = coeff[4] - kz * (deviator - coeff[5]);
-                G = coeff[8] - kg * (deviator - coeff[9]);
-            }
-            break;
+    std::vector<double> bulk(n), deviator(n), octahedral(n), scratch(3 * n);
+    for (int k = 0; k < n; k++) {
+        bulk[k] = std::abs(sigma1[k] + sigma2[k] + sigma3[k]);
+        deviator[k] = std::abs(sigma1[k] - sigma3[k]);
+        double a = sigma1[k] - sigma2[k], b = sigma2[k] - sigma3[k], c = sigma1[k] - sigma3[k];
+        octahedral[k] = std::sqrt(a * a + b * b + c * c) / 3;
+    }
+    StressInvariants in = {n, bulk.data(), deviator.data(), octahedral.data(), fastMath};
+
+    // Coefficients of the horizontal, vertical & shear modulus (isotropic models fill the vertical one only)
+    double* out[3] = {Mr, Mz, G};
+    for (int c = 0; c < 3; c++) {
+        double* M = out[c];
+        if ((!anisotropy && c != 1) || resilientModel == NULL)
+            std::fill(M, M + n, 0.0);
+        else
+            resilientModel->evaluate(in, coeff.data() + (anisotropy ? c * resilientModel->coefficients : 0), M, scratch.data());
     }
-    VectorXd result(3);
-    result << Mr, Mz, G;
-    return result;
+}
+
+VectorXd NonlinearElastic::modulusGradient(const VectorXd & stress) const
+{
+    VectorXd gradient = VectorXd::Zero(4);
+    if (anisotropy)
+        return gradient;
+
+    // Principal stresses (sigma3, sigma2, sigma1) and directions of the axisymmetric stress tensor
+    Matrix3d tensor;
+    tensor << stress(0), 0, stress(3),
+              0, stress(1), 0,
+              stress(3), 0, stress(2);
+    SelfAdjointEigenSolver<Matrix3d> es(tensor);
+    Vector3d principal = es.eigenvalues();
+    // d(sigma_k)/d(sigma_r, sigma_theta, sigma_z, tau_rz) = (n_r^2, n_theta^2, n_z^2, 2 n_r n_z)
+    auto principalDeriv = [&](int k) {
+        Vector3d n = es.eigenvectors().col(k);
+        Vector4d d;
+        d << n(0) * n(0), n(1) * n(1), n(2) * n(2), 2 * n(0) * n(2);
+        return d;
+    };
+
+    // Derivatives of the stress invariants used by the models
+    double trace = principal.sum();
+    double bulk = std::abs(trace);
+    double deviator = std::abs(principal(2) - principal(0));
+    double a = principal(2) - principal(1), b = principal(1) - principal(0), c = principal(2) - principal(0);
+    double octahedral = std::sqrt(a * a + b * b + c * c) / 3;
+    Vector4d dBulk(1, 1, 1, 0);
+    dBulk *= trace < 0 ? -1 : 1;
+    Vector4d dDeviator = principalDeriv(2) - principalDeriv(0);
+    Vector4d dOctahedral = Vector4d::Zero();
+    if (octahedral > 0) // tau_oct^2 = 2/3 J2, dJ2/dsigma = (s_r, s_theta, s_z, 2 tau_rz)
+        dOctahedral << stress(0) - trace / 3, stress(1) - trace / 3, stress(2) - trace / 3, 2 * stress(3);
+    dOctahedral /= octahedral > 0 ? 3 * octahedral : 1;
+
+    // dM/dsigma = dM/dtheta * dtheta/dsigma + dM/dsigma_d * dsigma_d/dsigma + dM/dtau_oct * dtau_oct/dsigma
+    double M = stressDependentModulus(principal)(1);
+    double f[3] = {0, 0, 0};
+    if (resilientModel != NULL)
+        resilientModel->sensitivity(coeff.data(), M, bulk, deviator, octahedral, f);
+    double fBulk = f[0], fDeviator = f[1], fOctahedral = f[2];
+    gradient = fBulk * dBulk + fDeviator * dDeviator + fOctahedral * dOctahedral;
+    return gradient;
 }
 
 MatrixXd NonlinearElastic::EMatrix(const VectorXd & modulus) const
 {
-    MatrixXd E(4,4);
-    if (!anisotropy) {
-        E << 1 - v_, v_, v_, 0,
-              v_,   1-v_, v_, 0,
-              v_,   v_,  1-v_, 0,
-              0,  0,    0,  (1-2*v_)/2;
-        E = E * modulus(0) / (1+v_) /(1-2*v_);
-    } else {
-        double n = modulus(0) / modulus(1); // Mr / Mz
-        double m = modulus(2) / modulus(1); // G / Mz
-        double A = modulus(1) / (1 + vr_) / (1 - vr_ - 2 * n * vz_ * vz_);
-        E <<  n * (1 - n * vz_ * vz_), n * (vr_ + n * vz_ * vz_), n * vz_ * (1 + vr_), 0,
-              n * (vr_ + n * vz_ * vz_), n * (1 - n * vz_ * vz_), n * vz_ * (1 + vr_), 0,
-              n * vz_ * (1 + vr_), n * vz_ * (1 + vr_), 1 - vr_ * vr_, 0,
-              0, 0, 0, m * (1 + vr_) * (1 - vr_ - 2 * n * vz_ * vz_);
-        E = E * A;
-    }
+    Matrix4d E;
+    if (!anisotropy)
+        IsotropicElasticity(*this).build(modulus(0), E);
+    else
+        CrossAnisotropicElasticity(*this).build(modulus(0), modulus(1), modulus(2), E);
     return E;
 }
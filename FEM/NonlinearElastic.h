@@ -11,6 +11,7 @@
 #define NonlinearElastic_h
 
 #include "Material.h"
+#include "ResilientModel.h"
 
 class NonlinearElastic : public Material
 {
@@ -20,11 +21,16 @@ class NonlinearElastic : public Material
     ~NonlinearElastic();
 
     VectorXd stressDependentModulus(const VectorXd & stress) const;
+    void stressDependentModulus(const int & n, const double* sigma3, const double* sigma2, const double* sigma1, double* Mr, double* Mz, double* G) const;
+    VectorXd modulusGradient(const VectorXd & stress) const;
     MatrixXd EMatrix(const VectorXd & modulus) const;
+    std::vector<double> parameters() const;
+    int model() const;
 
   protected:
     int modelNo; /* Designator for resilient model used */
     std::vector<double> coeff; /** Regression coefficients used in the resilient model */
+    const ResilientModelRegistry::Entry* resilientModel; /* The registered model of modelNo, looked up once */
 
 };
 
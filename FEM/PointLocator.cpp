@@ -0,0 +1,111 @@
+/**
+ * @file PointLocator.cpp
+ * Implementation of PointLocator class.
+ */
+
+#include "PointLocator.h"
+#include <algorithm>
+#include <cmath>
+
+PointLocator::PointLocator(const Mesh & mesh)
+  : mesh_(mesh), origin_(HUGE_VAL, HUGE_VAL), cell_(1, 1), nr_(1), nz_(1)
+{
+    // Bounding boxes of the quadrilateral elements (bars and interfaces are skipped)
+    const std::vector<Material*> & materials = mesh.materialList;
+    std::vector<int> quads;
+    std::vector<Vector2d> lower, upper;
+    Vector2d top(-HUGE_VAL, -HUGE_VAL);
+    layer_.assign(mesh.elementCount(), -1);
+    for (int i = 0; i < mesh.elementCount(); i++) {
+        Element* curr = mesh.elementArray()[i];
+        layer_[i] = (int)(std::find(materials.begin(), materials.end(), curr->material()) - materials.begin());
+        if (curr->getSize() != 4 && curr->getSize() != 8)
+            continue;
+        const MatrixXd & coord = curr->getNodeCoord();
+        quads.push_back(i);
+        lower.push_back(coord.colwise().minCoeff().transpose());
+        upper.push_back(coord.colwise().maxCoeff().transpose());
+        origin_ = origin_.cwiseMin(lower.back());
+        top = top.cwiseMax(upper.back());
+    }
+    if (quads.empty())
+        return;
+
+    // About one element per cell, with square-ish cells
+    Vector2d extent = (top - origin_).cwiseMax(1e-12);
+    double n = (double)quads.size();
+    nr_ = std::max(1, (int)std::ceil(std::sqrt(n * extent(0) / extent(1))));
+    nz_ = std::max(1, (int)std::ceil(n / nr_));
+    cell_ << extent(0) / nr_, extent(1) / nz_;
+
+    // Bin the boxes in two passes, counting and then filling
+    std::vector<int> cellRange(4 * quads.size());
+    for (unsigned q = 0; q < quads.size(); q++) {
+        cellRange[4 * q] = std::min(nr_ - 1, (int)((lower[q](0) - origin_(0)) / cell_(0)));
+        cellRange[4 * q + 1] = std::min(nr_ - 1, (int)((upper[q](0) - origin_(0)) / cell_(0)));
+        cellRange[4 * q + 2] = std::min(nz_ - 1, (int)((lower[q](1) - origin_(1)) / cell_(1)));
+        cellRange[4 * q + 3] = std::min(nz_ - 1, (int)((upper[q](1) - origin_(1)) / cell_(1)));
+    }
+    cellStart_.assign(nr_ * nz_ + 1, 0);
+    for (unsigned q = 0; q < quads.size(); q++)
+        for (int iz = cellRange[4 * q + 2]; iz <= cellRange[4 * q + 3]; iz++)
+            for (int ir = cellRange[4 * q]; ir <= cellRange[4 * q + 1]; ir++)
+                cellStart_[iz * nr_ + ir + 1]++;
+    for (int c = 0; c < nr_ * nz_; c++)
+        cellStart_[c + 1] += cellStart_[c];
+    cellElements_.resize(cellStart_.back());
+    std::vector<int> fill(cellStart_.begin(), cellStart_.end() - 1);
+    for (unsigned q = 0; q < quads.size(); q++)
+        for (int iz = cellRange[4 * q + 2]; iz <= cellRange[4 * q + 3]; iz++)
+            for (int ir = cellRange[4 * q]; ir <= cellRange[4 * q + 1]; ir++)
+                cellElements_[fill[iz * nr_ + ir]++] = quads[q];
+}
+
+PointLocator::~PointLocator()
+{
+}
+
+bool PointLocator::locate(const Vector2d & point, const int & layer, int & element, Vector2d & local) const
+{
+    if (cellElements_.empty())
+        return false;
+    int ir = (int)std::floor((point(0) - origin_(0)) / cell_(0));
+    int iz = (int)std::floor((point(1) - origin_(1)) / cell_(1));
+    ir = std::min(std::max(ir, 0), nr_ - 1);
+    iz = std::min(std::max(iz, 0), nz_ - 1);
+    int c = iz * nr_ + ir;
+    for (int k = cellStart_[c]; k < cellStart_[c + 1]; k++) {
+        int e = cellElements_[k];
+        if (layer >= 0 && layer_[e] != layer)
+            continue;
+        if (inverseMap_(e, point, local)) {
+            element = e;
+            return true;
+        }
+    }
+    return false;
+}
+
+const int & PointLocator::layer(const int & element) const
+{
+    return layer_[element];
+}
+
+bool PointLocator::inverseMap_(const int & element, const Vector2d & point, Vector2d & local) const
+{
+    Element* curr = mesh_.elementArray()[element];
+    const MatrixXd & coord = curr->getNodeCoord();
+    Shape* shape = curr->shape();
+    local.setZero();
+    for (int it = 0; it < 20; it++) {
+        Vector2d residual = point - coord.transpose() * shape->functionVec(local);
+        Matrix2d J = shape->functionDeriv(local) * coord; // J(i, j) = dx_j / dxi_i
+        Vector2d delta = J.transpose().partialPivLu().solve(residual);
+        local += delta;
+        if (!local.allFinite() || local.cwiseAbs().maxCoeff() > 10)
+            return false; // far outside, or a degenerate map
+        if (delta.norm() < 1e-10)
+            break;
+    }
+    return local.cwiseAbs().maxCoeff() <= 1 + 1e-6;
+}
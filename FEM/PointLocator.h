@@ -0,0 +1,81 @@
+/**
+ * @file PointLocator.h
+ * Point location over the quadrilateral elements of a mesh.
+ */
+
+#ifndef PointLocator_h
+#define PointLocator_h
+
+#include "Mesh.h"
+#include "Eigen/Eigen"
+#include <vector>
+
+using namespace Eigen;
+
+/* Finds the Q4/Q8 element of a mesh that contains a point, and the local
+ * coordinates of the point in it. The bounding boxes of the elements are
+ * binned into a uniform grid of about one element per cell, so a query only
+ * tests the elements of one cell: each candidate is inverted by Newton's
+ * method on the isoparametric map x(xi) = N(xi) X, and is accepted when the
+ * local coordinates lie in [-1, 1]^2 within a tolerance.
+ */
+class PointLocator
+{
+  public:
+    /**
+     * Custom constructor.
+     *
+     * @param mesh The mesh to be searched, which must outlive the locator.
+     */
+    explicit PointLocator(const Mesh & mesh);
+
+    ~PointLocator();
+
+    /**
+     * Locate a point.
+     *
+     * @param point The global coordinates (r, z).
+     * @param layer The index of the material in Mesh::materialList the element
+     * must have, or -1 for any material.
+     * @param element The index of the containing element.
+     * @param local The local coordinates in the containing element.
+     * @return Whether an element contains the point.
+     */
+    bool locate(const Vector2d & point, const int & layer, int & element, Vector2d & local) const;
+
+    /**
+     * Get the material index of an element.
+     *
+     * @param element The element index.
+     * @return The index of its material in Mesh::materialList.
+     */
+    const int & layer(const int & element) const;
+
+  private:
+    /** The mesh */
+    const Mesh & mesh_;
+
+    /** The grid origin and cell size */
+    Vector2d origin_, cell_;
+
+    /** The number of cells in r and z */
+    int nr_, nz_;
+
+    /** The elements overlapping each cell, in compressed rows: cellStart_[c] to cellStart_[c + 1] of cellElements_ */
+    std::vector<int> cellStart_, cellElements_;
+
+    /** Material index of each element */
+    std::vector<int> layer_;
+
+    /**
+     * Private helper function to invert the isoparametric map of an element.
+     *
+     * @param element The element index.
+     * @param point The global coordinates.
+     * @param local The local coordinates.
+     * @return Whether the point lies in the element.
+     */
+    bool inverseMap_(const int & element, const Vector2d & point, Vector2d & local) const;
+};
+
+#endif /* PointLocator_h */
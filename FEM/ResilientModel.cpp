@@ -0,0 +1,130 @@
+/**
+ * @file ResilientModel.cpp
+ * Implementation of the resilient modulus models and their registry.
+ */
+
+#include "ResilientModel.h"
+#include "FastMath.h"
+
+static const double atm = 14.696; // atmospheric pressure, 101.325 kPa or 14.7 psi
+
+void ResilientModelRegistry::add(const int & id, const Entry & entry)
+{
+    table()[id] = entry;
+}
+
+const ResilientModelRegistry::Entry* ResilientModelRegistry::find(const int & id)
+{
+    std::map<int, Entry>::const_iterator it = table().find(id);
+    return it == table().end() ? NULL : &it->second;
+}
+
+std::map<int, ResilientModelRegistry::Entry> & ResilientModelRegistry::table()
+{
+    static std::map<int, Entry> models;
+    return models;
+}
+
+void KThetaModel::evaluate(const StressInvariants & in, const double* k, double* M, double* scratch)
+{
+    arrayPow(in.n, in.bulk, k[1], scratch, in.fast);
+    for (int j = 0; j < in.n; j++)
+        M[j] = k[0] * scratch[j];
+}
+
+void KThetaModel::sensitivity(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f)
+{
+    (void)deviator;
+    (void)octahedral;
+    f[0] = bulk > 0 ? k[1] * M / bulk : 0;
+    f[1] = 0;
+    f[2] = 0;
+}
+
+void UzanModel::evaluate(const StressInvariants & in, const double* k, double* M, double* scratch)
+{
+    double* powerA = scratch;
+    double* powerB = scratch + in.n;
+    arrayPow(in.n, in.bulk, k[1], powerA, in.fast);
+    arrayPow(in.n, in.deviator, k[2], powerB, in.fast);
+    for (int j = 0; j < in.n; j++)
+        M[j] = k[0] * powerA[j] * powerB[j];
+}
+
+void UzanModel::sensitivity(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f)
+{
+    (void)octahedral;
+    f[0] = bulk > 0 ? k[1] * M / bulk : 0;
+    f[1] = deviator > 0 ? k[2] * M / deviator : 0;
+    f[2] = 0;
+}
+
+void UniversalModel::evaluate(const StressInvariants & in, const double* k, double* M, double* scratch)
+{
+    double* powerA = scratch;
+    double* powerB = scratch + in.n;
+    double* scaled = scratch + 2 * in.n;
+    for (int j = 0; j < in.n; j++)
+        scaled[j] = in.bulk[j] / atm;
+    arrayPow(in.n, scaled, k[1], powerA, in.fast);
+    for (int j = 0; j < in.n; j++)
+        scaled[j] = in.octahedral[j] / atm;
+    arrayPow(in.n, scaled, k[2], powerB, in.fast);
+    for (int j = 0; j < in.n; j++)
+        M[j] = k[0] * atm * powerA[j] * powerB[j];
+}
+
+void UniversalModel::sensitivity(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f)
+{
+    (void)deviator;
+    f[0] = bulk > 0 ? k[1] * M / bulk : 0;
+    f[1] = 0;
+    f[2] = octahedral > 0 ? k[2] * M / octahedral : 0;
+}
+
+void MEPDGModel::evaluate(const StressInvariants & in, const double* k, double* M, double* scratch)
+{
+    double* powerA = scratch;
+    double* powerB = scratch + in.n;
+    double* scaled = scratch + 2 * in.n;
+    for (int j = 0; j < in.n; j++)
+        scaled[j] = in.bulk[j] / atm;
+    arrayPow(in.n, scaled, k[1], powerA, in.fast);
+    for (int j = 0; j < in.n; j++)
+        scaled[j] = in.octahedral[j] / atm + 1;
+    arrayPow(in.n, scaled, k[2], powerB, in.fast);
+    for (int j = 0; j < in.n; j++)
+        M[j] = k[0] * atm * powerA[j] * powerB[j];
+}
+
+void MEPDGModel::sensitivity(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f)
+{
+    (void)deviator;
+    f[0] = bulk > 0 ? k[1] * M / bulk : 0;
+    f[1] = 0;
+    f[2] = k[2] * M / (octahedral + atm);
+}
+
+void BilinearModel::evaluate(const StressInvariants & in, const double* k, double* M, double* scratch)
+{
+    (void)scratch;
+    for (int j = 0; j < in.n; j++)
+        M[j] = k[0] - (in.deviator[j] < k[1] ? k[2] : k[3]) * (in.deviator[j] - k[1]);
+}
+
+void BilinearModel::sensitivity(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f)
+{
+    (void)M;
+    (void)bulk;
+    (void)octahedral;
+    f[0] = 0;
+    f[1] = deviator < k[1] ? -k[2] : -k[3];
+    f[2] = 0;
+}
+
+// The built-in models
+static RegisterResilientModel<KThetaModel> kTheta;
+static RegisterResilientModel<UzanModel> uzan;
+static RegisterResilientModel<UniversalModel> universal;
+static RegisterResilientModel<MEPDGModel> mepdg;
+static RegisterResilientModel<BilinearModel> bilinear;
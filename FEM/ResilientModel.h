@@ -0,0 +1,141 @@
+/**
+ * @file ResilientModel.h
+ * Registry of the stress-dependent resilient modulus models.
+ */
+
+#ifndef ResilientModel_h
+#define ResilientModel_h
+
+#include <map>
+
+/* Each resilient model is a type with static members
+ *
+ *   id            the model number in the input file
+ *   coefficients  the number of regression coefficients per modulus
+ *   evaluate()    the modulus of a batch of Gaussian points
+ *   sensitivity() the derivatives of the modulus w.r.t. the stress invariants
+ *
+ * and is registered once by a RegisterResilientModel<Model> object. A
+ * NonlinearElastic material looks its model up when it is created, so the
+ * batched modulus update makes one call per element block and the hot loop
+ * never switches on the model number. A new model only needs its type and
+ * its registration.
+ */
+
+/** Stress invariants of a batch of Gaussian points, the input of every model */
+struct StressInvariants
+{
+    int n; /* Number of points */
+    const double* bulk; /* Bulk stress theta = |sigma1 + sigma2 + sigma3| */
+    const double* deviator; /* Deviatoric stress sigma_d = |sigma1 - sigma3| */
+    const double* octahedral; /* Octahedral shear stress tau_oct */
+    bool fast; /* Whether the powers use fastPow() of FastMath.h */
+};
+
+class ResilientModelRegistry
+{
+  public:
+    /**
+     * Batched modulus of a model.
+     *
+     * @param in The stress invariants.
+     * @param k The regression coefficients of the modulus.
+     * @param M The modulus of each point.
+     * @param scratch Workspace of 3 * in.n doubles.
+     */
+    typedef void (*Evaluator)(const StressInvariants & in, const double* k, double* M, double* scratch);
+
+    /**
+     * Derivatives of the modulus w.r.t. the bulk, deviatoric & octahedral stresses.
+     * They are closed forms in the modulus, e.g. k M / x for a power x^k, so
+     * they need no powers and the fast_math setting does not apply to them.
+     *
+     * @param k The regression coefficients of the modulus.
+     * @param M The modulus at the stress state.
+     * @param bulk, deviator, octahedral The stress invariants.
+     * @param f dM/dtheta, dM/dsigma_d, dM/dtau_oct.
+     */
+    typedef void (*Sensitivity)(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f);
+
+    /** A registered model */
+    struct Entry
+    {
+        Evaluator evaluate;
+        Sensitivity sensitivity;
+        int coefficients;
+    };
+
+    /**
+     * Register a model. A later registration of the same id replaces the earlier one.
+     *
+     * @param id The model number.
+     * @param entry The model.
+     */
+    static void add(const int & id, const Entry & entry);
+
+    /**
+     * Look up a model.
+     *
+     * @param id The model number.
+     * @return The model, or NULL if none is registered with this id.
+     */
+    static const Entry* find(const int & id);
+
+  private:
+    /** The registered models, created on first use so that registration works during static initialization */
+    static std::map<int, Entry> & table();
+};
+
+/** Registers the model type at construction, e.g. a static RegisterResilientModel<KThetaModel> object */
+template <class Model>
+class RegisterResilientModel
+{
+  public:
+    RegisterResilientModel()
+    {
+        ResilientModelRegistry::Entry entry = {&Model::evaluate, &Model::sensitivity, Model::coefficients};
+        ResilientModelRegistry::add(Model::id, entry);
+    }
+};
+
+/** K-theta model, M = k1 theta^k2 */
+struct KThetaModel
+{
+    enum { id = 1, coefficients = 3 }; // k3 is unused, 0 fills the triplet
+    static void evaluate(const StressInvariants & in, const double* k, double* M, double* scratch);
+    static void sensitivity(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f);
+};
+
+/** Uzan model, M = k1 theta^k2 sigma_d^k3 */
+struct UzanModel
+{
+    enum { id = 2, coefficients = 3 };
+    static void evaluate(const StressInvariants & in, const double* k, double* M, double* scratch);
+    static void sensitivity(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f);
+};
+
+/** Universal model, M = k1 pa (theta / pa)^k2 (tau_oct / pa)^k3 */
+struct UniversalModel
+{
+    enum { id = 3, coefficients = 3 };
+    static void evaluate(const StressInvariants & in, const double* k, double* M, double* scratch);
+    static void sensitivity(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f);
+};
+
+/** MEPDG model, M = k1 pa (theta / pa)^k2 (tau_oct / pa + 1)^k3 */
+struct MEPDGModel
+{
+    enum { id = 4, coefficients = 3 };
+    static void evaluate(const StressInvariants & in, const double* k, double* M, double* scratch);
+    static void sensitivity(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f);
+};
+
+/** Bilinear model, M = k1 - (sigma_d < k2 ? k3 : k4) (sigma_d - k2) */
+struct BilinearModel
+{
+    enum { id = 5, coefficients = 4 };
+    static void evaluate(const StressInvariants & in, const double* k, double* M, double* scratch);
+    static void sensitivity(const double* k, const double & M, const double & bulk, const double & deviator, const double & octahedral, double* f);
+};
+
+#endif /* ResilientModel_h */
@@ -0,0 +1,225 @@
+/**
+ * @file SkylineLDLT.cpp
+ * Implementation of SkylineLDLT class.
+ */
+
+#include "SkylineLDLT.h"
+#include <algorithm>
+#include <queue>
+
+SkylineLDLT::SkylineLDLT() : n_(0), factorized_(false), recomputed_(0)
+{
+}
+
+SkylineLDLT::~SkylineLDLT()
+{
+}
+
+void SkylineLDLT::analyzePattern(const SparseMatrix<double> & K)
+{
+    n_ = (int)K.cols();
+    reverseCuthillMcKee_(K);
+
+    // The skyline of each column: the first nonzero row in the upper triangle
+    first_.assign(n_, 0);
+    for (int j = 0; j < n_; j++)
+        first_[j] = j;
+    for (int c = 0; c < K.outerSize(); c++) {
+        int j = perm_[c];
+        for (SparseMatrix<double>::InnerIterator it(K, c); it; ++it) {
+            int i = perm_[it.row()];
+            if (i < first_[j])
+                first_[j] = i;
+        }
+    }
+
+    start_.assign(n_ + 1, 0);
+    for (int j = 0; j < n_; j++)
+        start_[j + 1] = start_[j] + (j - first_[j] + 1);
+    values_.assign(start_[n_], 0.0);
+    matrix_.assign(start_[n_], 0.0);
+    work_.assign(start_[n_], 0.0);
+    factorized_ = false;
+}
+
+bool SkylineLDLT::factorize(const SparseMatrix<double> & K)
+{
+    // Scatter the upper triangle of the permuted K into the skyline
+    std::fill(work_.begin(), work_.end(), 0.0);
+    for (int c = 0; c < K.outerSize(); c++) {
+        int j = perm_[c];
+        for (SparseMatrix<double>::InnerIterator it(K, c); it; ++it) {
+            int i = perm_[it.row()];
+            if (i <= j)
+                work_[start_[j] + i - first_[j]] += it.value();
+        }
+    }
+
+    // Columns with changed entries since the last factorization
+    std::vector<char> recompute(n_, 1);
+    if (factorized_)
+        for (int j = 0; j < n_; j++)
+            recompute[j] = !std::equal(work_.begin() + start_[j], work_.begin() + start_[j + 1], matrix_.begin() + start_[j]);
+    matrix_.swap(work_);
+
+    // Propagate to the ancestors: column k is recomputed if any recomputed
+    // column lies in its envelope. count[k] is the number of recomputed
+    // columns before k
+    std::vector<int> count(n_ + 1, 0);
+    for (int k = 0; k < n_; k++) {
+        if (!recompute[k] && count[k] > count[first_[k]])
+            recompute[k] = 1;
+        count[k + 1] = count[k] + recompute[k];
+    }
+
+    long entries = 0;
+    factorized_ = false;
+    for (int j = 0; j < n_; j++) {
+        if (!recompute[j])
+            continue;
+        std::copy(matrix_.begin() + start_[j], matrix_.begin() + start_[j + 1], values_.begin() + start_[j]);
+        if (!factorizeColumn_(j))
+            return false;
+        entries += start_[j + 1] - start_[j];
+    }
+    factorized_ = true;
+    recomputed_ = profile() > 0 ? (double)entries / profile() : 1;
+    return true;
+}
+
+bool SkylineLDLT::factorizeColumn_(const int & j)
+{
+    // Active column LDLT. For column j (rows first_[j]..j):
+    // 1. u(i,j) = a(i,j) - sum_k l(i,k) u(k,j), k from max(first_[i], first_[j]) to i-1
+    // 2. l(j,k) = u(k,j) / d(k) and d(j) = a(j,j) - sum_k u(k,j) * l(j,k)
+    // Column i (i < j) is already factorized, so both operands of every dot
+    // product are contiguous segments of the skyline storage.
+    double* colJ = &values_[start_[j]] - first_[j]; // colJ[i] is entry (i,j)
+    for (int i = first_[j] + 1; i < j; i++) {
+        const double* colI = &values_[start_[i]] - first_[i];
+        int m = std::max(first_[i], first_[j]);
+        if (m < i)
+            colJ[i] -= Map<const VectorXd>(colI + m, i - m).dot(Map<const VectorXd>(colJ + m, i - m));
+    }
+    double d = colJ[j];
+    for (int k = first_[j]; k < j; k++) {
+        double u = colJ[k];
+        colJ[k] = u / values_[start_[k + 1] - 1]; // diagonal of column k is its last entry
+        d -= u * colJ[k];
+    }
+    if (d == 0)
+        return false;
+    colJ[j] = d;
+    return true;
+}
+
+VectorXd SkylineLDLT::solve(const VectorXd & b) const
+{
+    VectorXd x(n_);
+    for (int i = 0; i < n_; i++)
+        x(perm_[i]) = b(i);
+
+    // Forward substitution L y = b, row j of L is column j of the skyline
+    for (int j = 0; j < n_; j++) {
+        int len = j - first_[j];
+        if (len > 0)
+            x(j) -= Map<const VectorXd>(&values_[start_[j]], len).dot(x.segment(first_[j], len));
+    }
+    // Diagonal D z = y
+    for (int j = 0; j < n_; j++)
+        x(j) /= values_[start_[j + 1] - 1];
+    // Backward substitution L^T x = z, column-oriented
+    for (int j = n_ - 1; j > 0; j--) {
+        int len = j - first_[j];
+        if (len > 0)
+            x.segment(first_[j], len) -= x(j) * Map<const VectorXd>(&values_[start_[j]], len);
+    }
+
+    VectorXd result(n_);
+    for (int i = 0; i < n_; i++)
+        result(i) = x(perm_[i]);
+    return result;
+}
+
+long SkylineLDLT::profile() const
+{
+    return start_.empty() ? 0 : start_[n_];
+}
+
+double SkylineLDLT::recomputedFraction() const
+{
+    return recomputed_;
+}
+
+void SkylineLDLT::reverseCuthillMcKee_(const SparseMatrix<double> & K)
+{
+    // Adjacency graph of the matrix (off-diagonal entries)
+    std::vector<int> degree(n_, 0);
+    for (int c = 0; c < K.outerSize(); c++)
+        for (SparseMatrix<double>::InnerIterator it(K, c); it; ++it)
+            if (it.row() != c)
+                degree[c]++;
+
+    std::vector<int> order;
+    order.reserve(n_);
+    std::vector<bool> visited(n_, false);
+    std::vector<int> level(n_, -1);
+
+    // Breadth-first search from root, neighbors visited in increasing degree.
+    // Returns the last level's node with the minimum degree, and appends to list
+    auto bfs = [&](int root, std::vector<int> & list, int & depth) {
+        list.clear();
+        list.push_back(root);
+        level[root] = 0;
+        std::vector<int> neighbors;
+        for (unsigned q = 0; q < list.size(); q++) {
+            int v = list[q];
+            neighbors.clear();
+            for (SparseMatrix<double>::InnerIterator it(K, v); it; ++it) {
+                int w = (int)it.row();
+                if (w != v && level[w] < 0 && !visited[w]) {
+                    level[w] = level[v] + 1;
+                    neighbors.push_back(w);
+                }
+            }
+            std::sort(neighbors.begin(), neighbors.end(), [&](int a, int b) { return degree[a] < degree[b] || (degree[a] == degree[b] && a < b); });
+            list.insert(list.end(), neighbors.begin(), neighbors.end());
+        }
+        depth = level[list.back()];
+        int best = list.back();
+        for (int v : list)
+            if (level[v] == depth && degree[v] < degree[best])
+                best = v;
+        for (int v : list)
+            level[v] = -1;
+        return best;
+    };
+
+    std::vector<int> list;
+    for (int s = 0; s < n_; s++) {
+        if (visited[s])
+            continue;
+        // Pseudo-peripheral root of this component (George & Liu)
+        int root = s;
+        int depth = 0;
+        int candidate = bfs(root, list, depth);
+        for (int iter = 0; iter < 10; iter++) {
+            int newDepth = 0;
+            int next = bfs(candidate, list, newDepth);
+            if (newDepth <= depth)
+                break;
+            root = candidate;
+            depth = newDepth;
+            candidate = next;
+        }
+        bfs(root, list, depth);
+        for (int v : list)
+            visited[v] = true;
+        order.insert(order.end(), list.begin(), list.end());
+    }
+
+    // Reverse the Cuthill-McKee order
+    perm_.assign(n_, 0);
+    for (int k = 0; k < n_; k++)
+        perm_[order[k]] = n_ - 1 - k;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file SkylineLDLT.h
+ * Skyline (variable-band) LDLT factorization of the global stiffness matrix.
+ */
+
+#ifndef SkylineLDLT_h
+#define SkylineLDLT_h
+
+#include "Eigen/Eigen"
+#include <vector>
+
+using namespace Eigen;
+
+/* Skyline LDLT solver for symmetric positive definite sparse matrices.
+ *
+ * Pavement meshes are generated column by column, so the global stiffness
+ * matrix has a narrow and predictable profile. After a Reverse Cuthill-McKee
+ * (RCM) renumbering that further minimizes the bandwidth, each column of the
+ * upper triangle is stored contiguously from its first nonzero row down to the
+ * diagonal (the "skyline"). The factorization is the active column scheme
+ * (Bathe & Wilson), where every update of a column is a dot product of two
+ * contiguous column segments, i.e. vectorized loops with sequential memory
+ * access instead of the indirect addressing of a general sparse factor.
+ *
+ * Partial refactorization: the matrix of the last factorization is kept, and
+ * on the next call only the columns whose entries changed and their ancestors
+ * in the elimination tree are recomputed. Column k of the factor depends on
+ * the columns in its envelope (rows first_[k]..k-1), so it is an ancestor of
+ * every such column and must be recomputed if any of them is. The remaining
+ * columns of the factor are reused as is, e.g. when only the nonlinear layers
+ * changed their moduli.
+ */
+class SkylineLDLT
+{
+  public:
+    SkylineLDLT();
+    ~SkylineLDLT();
+
+    /**
+     * Compute the RCM ordering and the skyline structure of the matrix.
+     *
+     * @param K The symmetric matrix with both triangles stored.
+     */
+    void analyzePattern(const SparseMatrix<double> & K);
+
+    /**
+     * Numerical factorization K = L D L^T on the analyzed structure. If a
+     * factorization is available, only the columns affected by the changed
+     * entries of K are recomputed.
+     *
+     * @param K The matrix with the analyzed pattern.
+     * @return True if succeeded (no zero pivot).
+     */
+    bool factorize(const SparseMatrix<double> & K);
+
+    /**
+     * Solve K x = b with the factorization.
+     *
+     * @param b The right-hand side.
+     * @return The solution x.
+     */
+    VectorXd solve(const VectorXd & b) const;
+
+    /**
+     * Get the number of stored entries of the skyline (the profile), which is
+     * also the number of entries of the factor.
+     *
+     * @return The profile size.
+     */
+    long profile() const;
+
+    /**
+     * Get the fraction of the factor entries recomputed by the last call of
+     * factorize (1 for a full factorization).
+     *
+     * @return The recomputed fraction.
+     */
+    double recomputedFraction() const;
+
+  private:
+    /** Size of the matrix */
+    int n_;
+
+    /** perm_[i] is the new index of old index i */
+    std::vector<int> perm_;
+
+    /** first_[j] is the first nonzero row of (permuted) column j */
+    std::vector<int> first_;
+
+    /** start_[j] is the offset of column j in values_, column j holds rows first_[j]..j */
+    std::vector<long> start_;
+
+    /** Skyline storage. After factorization, off-diagonal entries hold L^T and diagonal entries hold D */
+    std::vector<double> values_;
+
+    /** The permuted matrix of the last factorization in skyline storage, and its work copy */
+    std::vector<double> matrix_, work_;
+
+    /** Whether values_ holds the factor of matrix_ */
+    bool factorized_;
+
+    /** Fraction of the factor recomputed by the last factorization */
+    double recomputed_;
+
+
+    /**
+     * Private helper function for computing column j of the factor from
+     * column j of the matrix, given all the previous columns.
+     *
+     * @param j The column index.
+     * @return True if the pivot is nonzero.
+     */
+    bool factorizeColumn_(const int & j);
+
+    /**
+     * Private helper function for the Reverse Cuthill-McKee ordering.
+     *
+     * @param K The matrix whose graph is to be renumbered.
+     */
+    void reverseCuthillMcKee_(const SparseMatrix<double> & K);
+};
+
+#endif /* SkylineLDLT_h */
@@ -0,0 +1,104 @@
+/**
+ * @file StaticCondensation.cpp
+ * Implementation of StaticCondensation class.
+ */
+
+#include "StaticCondensation.h"
+#include <iostream>
+
+StaticCondensation::StaticCondensation() : analyzed_(false), interfaceCount_(0), out_(&std::cout)
+{
+}
+
+StaticCondensation::~StaticCondensation()
+{
+}
+
+void StaticCondensation::partition(const std::vector<bool> & regionDof)
+{
+    int n = (int)regionDof.size();
+    std::vector<Triplet<double> > interior, region;
+    for (int i = 0; i < n; i++) {
+        if (regionDof[i])
+            region.push_back(Triplet<double>(i, (int)region.size(), 1.0));
+        else
+            interior.push_back(Triplet<double>(i, (int)interior.size(), 1.0));
+    }
+    PI_.resize(n, interior.size());
+    PI_.setFromTriplets(interior.begin(), interior.end());
+    PN_.resize(n, region.size());
+    PN_.setFromTriplets(region.begin(), region.end());
+    analyzed_ = false;
+}
+
+void StaticCondensation::setStream(std::ostream & out)
+{
+    out_ = &out;
+}
+
+void StaticCondensation::solve(const SparseMatrix<double> & K, const VectorXd & F, VectorXd & U, StiffnessSolver & solver)
+{
+    if (!analyzed_)
+        analyze_(K);
+
+    // Condensed system on the nonlinear region
+    SparseMatrix<double> S = SparseMatrix<double>(PN_.transpose() * K * PN_) - correction_;
+    VectorXd FI = PI_.transpose() * F;
+    VectorXd y = interiorCount() > 0 ? VectorXd(interiorFactor_.solve(FI)) : FI;
+    VectorXd FS = PN_.transpose() * F - KIN_.transpose() * y;
+    VectorXd UN = U.size() == F.size() ? VectorXd(PN_.transpose() * U) : VectorXd::Zero(regionCount());
+    solver.solve(S, FS, UN);
+
+    // Recover the interior
+    VectorXd UI = y;
+    if (interiorCount() > 0)
+        UI -= interiorFactor_.solve(KIN_ * UN);
+    U = PI_ * UI + PN_ * UN;
+}
+
+int StaticCondensation::regionCount() const
+{
+    return (int)PN_.cols();
+}
+
+int StaticCondensation::interiorCount() const
+{
+    return (int)PI_.cols();
+}
+
+int StaticCondensation::interfaceCount() const
+{
+    return interfaceCount_;
+}
+
+void StaticCondensation::analyze_(const SparseMatrix<double> & K)
+{
+    if (PI_.rows() != K.rows())
+        partition(std::vector<bool>(K.rows(), true));
+
+    KIN_ = PI_.transpose() * K * PN_;
+    std::vector<int> interface;
+    for (int c = 0; c < KIN_.outerSize(); c++)
+        if (KIN_.outerIndexPtr()[c + 1] > KIN_.outerIndexPtr()[c])
+            interface.push_back(c);
+    interfaceCount_ = (int)interface.size();
+
+    // C = K_NI K_II^-1 K_IN restricted to the interface columns
+    std::vector<Triplet<double> > triplets;
+    if (interiorCount() > 0) {
+        interiorFactor_.compute(SparseMatrix<double>(PI_.transpose() * K * PI_));
+        MatrixXd KIG(interiorCount(), interfaceCount_);
+        for (int g = 0; g < interfaceCount_; g++)
+            KIG.col(g) = KIN_.col(interface[g]);
+        MatrixXd C = KIG.transpose() * interiorFactor_.solve(KIG);
+        triplets.reserve(interfaceCount_ * interfaceCount_);
+        for (int b = 0; b < interfaceCount_; b++)
+            for (int a = 0; a < interfaceCount_; a++)
+                triplets.push_back(Triplet<double>(interface[a], interface[b], C(a, b)));
+    }
+    correction_.resize(regionCount(), regionCount());
+    correction_.setFromTriplets(triplets.begin(), triplets.end());
+    analyzed_ = true;
+
+    *out_ << "Static condensation: region DOFs = " << regionCount() << ", interior DOFs = " << interiorCount() << ", interface DOFs = " << interfaceCount_ << std::endl;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file StaticCondensation.h
+ * Static condensation of the linear layers onto the nonlinear region.
+ */
+
+#ifndef StaticCondensation_h
+#define StaticCondensation_h
+
+#include "Eigen/Eigen"
+#include "StiffnessSolver.h"
+#include <iostream>
+#include <vector>
+
+using namespace Eigen;
+
+/* Substructuring solver for K U = F when only part of the stiffness changes.
+ *
+ * The DOFs are partitioned into the nonlinear region N (every DOF of a
+ * nonlinear element, including the interface with the linear layers) and the
+ * linear interior I (DOFs touched only by linear elements):
+ *
+ *   [K_II K_IN] [U_I]   [F_I]
+ *   [K_NI K_NN] [U_N] = [F_N]
+ *
+ * K_II and K_IN are assembled from linear elements only, so they are constant
+ * during the nonlinear scheme. K_II is factorized once, and the correction
+ * C = K_NI K_II^-1 K_IN of the Schur complement is formed once. C is nonzero
+ * only on the interface DOFs (the region DOFs coupled to the interior), so it
+ * is a small dense block. Each call then solves only the condensed system
+ *
+ *   (K_NN - C) U_N = F_N - K_NI K_II^-1 F_I
+ *
+ * with the given StiffnessSolver, and recovers the interior by
+ * U_I = K_II^-1 (F_I - K_IN U_N).
+ */
+class StaticCondensation
+{
+  public:
+    StaticCondensation();
+    ~StaticCondensation();
+
+    /**
+     * Set the partition of the DOFs. The blocks are formed at the next solve.
+     *
+     * @param regionDof regionDof[i] is true if DOF i belongs to the nonlinear region.
+     */
+    void partition(const std::vector<bool> & regionDof);
+
+    /**
+     * Set the stream of the progress message, std::cout by default.
+     *
+     * @param out The stream.
+     */
+    void setStream(std::ostream & out);
+
+    /**
+     * Solve K U = F by condensation onto the nonlinear region.
+     *
+     * @param K The global stiffness matrix.
+     * @param F The global force vector.
+     * @param U The nodal displacement. On entry the region part is the initial
+     * guess for the iterative modes; on exit it is the solution.
+     * @param solver The solver for the condensed system.
+     */
+    void solve(const SparseMatrix<double> & K, const VectorXd & F, VectorXd & U, StiffnessSolver & solver);
+
+    /**
+     * Get the number of DOFs of the nonlinear region (including interface).
+     *
+     * @return The region size.
+     */
+    int regionCount() const;
+
+    /**
+     * Get the number of DOFs of the linear interior.
+     *
+     * @return The interior size.
+     */
+    int interiorCount() const;
+
+    /**
+     * Get the number of interface DOFs.
+     *
+     * @return The interface size.
+     */
+    int interfaceCount() const;
+
+  private:
+    /** Whether the constant blocks are formed */
+    bool analyzed_;
+
+    /** Selection matrices, U = P_I U_I + P_N U_N */
+    SparseMatrix<double> PI_, PN_;
+
+    /** The constant coupling block K_IN */
+    SparseMatrix<double> KIN_;
+
+    /** The factorization of the constant interior block K_II */
+    SimplicialLDLT<SparseMatrix<double> > interiorFactor_;
+
+    /** The constant Schur complement correction C = K_NI K_II^-1 K_IN */
+    SparseMatrix<double> correction_;
+
+    /** Number of interface DOFs */
+    int interfaceCount_;
+
+    /** The stream of the progress message */
+    std::ostream* out_;
+
+    /**
+     * Private helper function for forming the constant blocks.
+     *
+     * @param K The global stiffness matrix.
+     */
+    void analyze_(const SparseMatrix<double> & K);
+};
+
+#endif /* StaticCondensation_h */
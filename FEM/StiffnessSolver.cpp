@@ -0,0 +1,390 @@
+/**
+ * @file StiffnessSolver.cpp
+ * Implementation of StiffnessSolver class.
+ */
+
+#include "StiffnessSolver.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+/* Nonzeros of the factor L (with its diagonal) of P K P^T, counted along the
+ * elimination tree as in the symbolic analysis of SimplicialLDLT */
+static long choleskyFill(const SparseMatrix<double> & K, const PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> & P)
+{
+    int n = (int)K.rows();
+    SparseMatrix<double> A;
+    A = K.selfadjointView<Lower>().twistedBy(P);
+    std::vector<int> parent(n, -1), flag(n);
+    long fill = n;
+    for (int k = 0; k < n; k++) {
+        flag[k] = k;
+        for (SparseMatrix<double>::InnerIterator it(A, k); it; ++it) {
+            // Walk up the tree from each i < k of column k, each new node is a nonzero of row k
+            for (int i = (int)it.index(); i < k && flag[i] != k; i = parent[i]) {
+                if (parent[i] == -1)
+                    parent[i] = k;
+                fill++;
+                flag[i] = k;
+            }
+        }
+    }
+    return fill;
+}
+
+StiffnessSolver::StiffnessSolver()
+  : mode_(DIRECT), refactorIterations_(20), tolerance_(1e-10), factorization_(SIMPLICIAL), skylineRatio_(1),
+    useSkyline_(false), analyzed_(false), factorized_(false), held_(false),
+    recycleVectors_(0), out_(&std::cout), err_(&std::cerr), factorizations_(0), iterations_(0), solves_(0), firstIterations_(0), lastIterations_(0), coldReference_(0), coldIterations_(0), recomputedSum_(0), factorTime_(0)
+{
+}
+
+StiffnessSolver::StiffnessSolver(std::string const & mode, const int & refactorIterations, const double & tolerance, const int & recycleVectors,
+                                 std::string const & factorization, const double & skylineRatio)
+  : mode_(DIRECT), refactorIterations_(refactorIterations), tolerance_(tolerance), factorization_(SIMPLICIAL), skylineRatio_(skylineRatio),
+    useSkyline_(false), analyzed_(false), factorized_(false), held_(false),
+    recycleVectors_(recycleVectors), out_(&std::cout), err_(&std::cerr), factorizations_(0), iterations_(0), solves_(0), firstIterations_(0), lastIterations_(0), coldReference_(0), coldIterations_(0), recomputedSum_(0), factorTime_(0)
+{
+    if (mode == "pcg")
+        mode_ = STALE_PCG;
+    else if (mode == "cg")
+        mode_ = DEFLATED_CG;
+    else if (mode != "direct")
+        std::cerr << "WARNING: Unknown solver \"" << mode << "\", use direct solver instead." << std::endl;
+    if (factorization == "skyline")
+        factorization_ = SKYLINE;
+    else if (factorization == "auto")
+        factorization_ = AUTO;
+    else if (factorization != "simplicial")
+        std::cerr << "WARNING: Unknown factorization \"" << factorization << "\", use simplicial instead." << std::endl;
+}
+
+StiffnessSolver::StiffnessSolver(Mesh const & mesh)
+  : StiffnessSolver(mesh.settingString("solver", "direct"), (int)mesh.setting("refactor_iterations", 20), mesh.setting("pcg_tolerance", 1e-10),
+                    (int)mesh.setting("recycle_vectors", 16), mesh.settingString("factorization", "simplicial"), mesh.setting("skyline_ratio", 1))
+{
+}
+
+StiffnessSolver::StiffnessSolver(const StiffnessSolver & other)
+  : mode_(other.mode_), refactorIterations_(other.refactorIterations_), tolerance_(other.tolerance_), factorization_(other.factorization_), skylineRatio_(other.skylineRatio_),
+    useSkyline_(false), analyzed_(false), factorized_(false), held_(false),
+    recycleVectors_(other.recycleVectors_), out_(other.out_), err_(other.err_), factorizations_(0), iterations_(0), solves_(0), firstIterations_(0), lastIterations_(0), coldReference_(0), coldIterations_(0), recomputedSum_(0), factorTime_(0)
+{
+}
+
+StiffnessSolver::~StiffnessSolver()
+{
+}
+
+void StiffnessSolver::solve(const SparseMatrix<double> & K, const VectorXd & F, VectorXd & U)
+{
+    if (mode_ == DEFLATED_CG) {
+        deflatedCG_(K, F, U);
+        return;
+    }
+    if (held_ && factorized_ && samePattern_(K)) {
+        U = factorSolve_(F);
+        return;
+    }
+    if (mode_ == STALE_PCG && factorized_ && samePattern_(K) && U.size() == F.size()) {
+        // Try the cheap way first: PCG preconditioned by the last factorization
+        if (pcg_(K, F, U))
+            return;
+        // Too many iterations means the factor is too stale, refactorize below
+    }
+    factorize_(K);
+    U = factorSolve_(F);
+}
+
+void StiffnessSolver::reset()
+{
+    factorized_ = false;
+}
+
+void StiffnessSolver::hold(const bool & held)
+{
+    held_ = held;
+}
+
+void StiffnessSolver::setStreams(std::ostream & out, std::ostream & err)
+{
+    out_ = &out;
+    err_ = &err;
+}
+
+const StiffnessSolver::Mode & StiffnessSolver::mode() const
+{
+    return mode_;
+}
+
+const int & StiffnessSolver::factorizations() const
+{
+    return factorizations_;
+}
+
+const double & StiffnessSolver::factorTime() const
+{
+    return factorTime_;
+}
+
+const int & StiffnessSolver::iterations() const
+{
+    return iterations_;
+}
+
+const int & StiffnessSolver::solves() const
+{
+    return solves_;
+}
+
+const int & StiffnessSolver::firstIterations() const
+{
+    return firstIterations_;
+}
+
+const int & StiffnessSolver::lastIterations() const
+{
+    return lastIterations_;
+}
+
+const int & StiffnessSolver::coldIterations() const
+{
+    return coldIterations_;
+}
+
+const bool & StiffnessSolver::skyline() const
+{
+    return useSkyline_;
+}
+
+double StiffnessSolver::recomputedFraction() const
+{
+    return useSkyline_ ? skyline_.recomputedFraction() : 1;
+}
+
+double StiffnessSolver::averageRecomputedFraction() const
+{
+    return factorizations_ > 0 ? recomputedSum_ / factorizations_ : 0;
+}
+
+void StiffnessSolver::factorize_(const SparseMatrix<double> & K)
+{
+    auto start = std::chrono::steady_clock::now();
+    // The pattern of K is fixed during the whole nonlinear scheme, so the
+    // ordering and elimination tree are computed only once
+    if (!analyzed_ || !samePattern_(K)) {
+        useSkyline_ = factorization_ == SKYLINE;
+        if (factorization_ == AUTO) {
+            // Compare the AMD fill of the general factor (known after the
+            // symbolic analysis) with the RCM profile, then factorize only one
+            factor_.analyzePattern(K);
+            long fill = choleskyFill(K, factor_.permutationP());
+            skyline_.analyzePattern(K);
+            useSkyline_ = skyline_.profile() <= skylineRatio_ * fill;
+            *out_ << "Factorization: " << (useSkyline_ ? "skyline" : "simplicial") << " (RCM profile = " << skyline_.profile() << ", AMD fill = " << fill << ")" << std::endl;
+        }
+        else if (useSkyline_)
+            skyline_.analyzePattern(K);
+        else
+            factor_.analyzePattern(K);
+        outerIndex_ = Map<const VectorXi>(K.outerIndexPtr(), K.outerSize() + 1);
+        innerIndex_ = Map<const VectorXi>(K.innerIndexPtr(), K.nonZeros());
+        analyzed_ = true;
+    }
+    if (useSkyline_) {
+        if (!skyline_.factorize(K)) {
+            // Zero pivot in the unpivoted skyline, fall back to the general factor for good
+            *err_ << "WARNING: Skyline factorization failed, use simplicial factorization instead." << std::endl;
+            useSkyline_ = false;
+            factor_.analyzePattern(K);
+            factor_.factorize(K);
+        }
+    }
+    else
+        factor_.factorize(K);
+    factorized_ = true;
+    factorizations_++;
+    recomputedSum_ += recomputedFraction();
+    factorTime_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+VectorXd StiffnessSolver::factorSolve_(const VectorXd & b) const
+{
+    if (useSkyline_)
+        return skyline_.solve(b);
+    return factor_.solve(b);
+}
+
+bool StiffnessSolver::samePattern_(const SparseMatrix<double> & K) const
+{
+    if (!K.isCompressed() || outerIndex_.size() != K.outerSize() + 1 || innerIndex_.size() != K.nonZeros())
+        return false;
+    return outerIndex_ == Map<const VectorXi>(K.outerIndexPtr(), K.outerSize() + 1)
+        && innerIndex_ == Map<const VectorXi>(K.innerIndexPtr(), K.nonZeros());
+}
+
+bool StiffnessSolver::pcg_(const SparseMatrix<double> & K, const VectorXd & F, VectorXd & U)
+{
+    double normF = F.norm();
+    if (normF == 0) {
+        U.setZero();
+        return true;
+    }
+    double threshold = tolerance_ * tolerance_ * normF * normF;
+
+    // Preconditioned conjugate gradient, M^-1 = (L D L^T)^-1 of the stale K
+    VectorXd r = F - K * U;
+    if (r.squaredNorm() < threshold)
+        return true;
+    VectorXd z = factorSolve_(r);
+    VectorXd p = z;
+    VectorXd Kp(F.size());
+    double rz = r.dot(z);
+    for (int i = 1; i <= refactorIterations_; i++) {
+        Kp.noalias() = K * p;
+        double alpha = rz / p.dot(Kp);
+        U += alpha * p;
+        r -= alpha * Kp;
+        iterations_++;
+        if (r.squaredNorm() < threshold)
+            return true;
+        z = factorSolve_(r);
+        double rzNew = r.dot(z);
+        p = z + (rzNew / rz) * p;
+        rz = rzNew;
+    }
+    return false;
+}
+
+void StiffnessSolver::deflatedCG_(const SparseMatrix<double> & K, const VectorXd & F, VectorXd & U)
+{
+    int n = (int)F.size();
+    if (U.size() != n)
+        U = VectorXd::Zero(n);
+    int start = iterations_;
+    solves_++;
+    lastIterations_ = 0;
+
+    double normF = F.norm();
+    if (normF == 0) {
+        U.setZero();
+        return;
+    }
+    double threshold = tolerance_ * tolerance_ * normF * normF;
+    VectorXd invDiag = K.diagonal().cwiseInverse(); // Jacobi preconditioner
+
+    // Deflation: E = W^T K W is a small k-by-k matrix, the coarse problem
+    int k = W_.rows() == n ? (int)W_.cols() : 0;
+    MatrixXd KW;
+    LDLT<MatrixXd> E;
+    if (k > 0) {
+        KW = K * W_;
+        E.compute(W_.transpose() * KW);
+        if (E.info() != Success || !E.isPositive())
+            k = 0;
+    }
+
+    // Cold-start reference: the un-deflated Jacobi CG from a zero guess, measured
+    // whenever the subspace is (re)built, stands for each solve until the next rebuild
+    // (without recycling there is no subspace, and the first solve is measured only)
+    if (k == 0 && (recycleVectors_ > 0 || coldReference_ == 0))
+        coldReference_ = coldCG_(K, F, invDiag, threshold);
+    coldIterations_ += coldReference_;
+
+    // Initial guess: previous solution, corrected in the deflation subspace so W^T r0 = 0
+    VectorXd r = F - K * U;
+    if (k > 0) {
+        U += W_ * E.solve(W_.transpose() * r);
+        r = F - K * U;
+    }
+
+    // Search directions of this solve are kept for harvesting the next subspace
+    int harvest = 2 * recycleVectors_;
+    MatrixXd P(n, harvest), KP(n, harvest);
+    int stored = 0;
+
+    if (r.squaredNorm() >= threshold) {
+        VectorXd z = invDiag.cwiseProduct(r);
+        VectorXd p = z;
+        if (k > 0)
+            p -= W_ * E.solve(KW.transpose() * z);
+        VectorXd Kp(n);
+        double rz = r.dot(z);
+        for (int i = 0; i < 10 * n; i++) {
+            Kp.noalias() = K * p;
+            double alpha = rz / p.dot(Kp);
+            if (stored < harvest) {
+                double normP = p.norm();
+                P.col(stored) = p / normP;
+                KP.col(stored) = Kp / normP;
+                stored++;
+            }
+            U += alpha * p;
+            r -= alpha * Kp;
+            iterations_++;
+            if (r.squaredNorm() < threshold)
+                break;
+            z = invDiag.cwiseProduct(r);
+            double rzNew = r.dot(z);
+            p = z + (rzNew / rz) * p;
+            if (k > 0)
+                p -= W_ * E.solve(KW.transpose() * z); // keep p K-orthogonal to W
+            rz = rzNew;
+        }
+    }
+    lastIterations_ = iterations_ - start;
+    if (solves_ == 1)
+        firstIterations_ = lastIterations_;
+    if (!(r.squaredNorm() < threshold)) {
+        // Not converged (or broken down), solve by factorization and restart the recycling
+        *err_ << "WARNING: Deflated CG did not converge in " << lastIterations_ << " iterations, solve by factorization instead." << std::endl;
+        factorize_(K);
+        U = factorSolve_(F);
+        W_.resize(0, 0);
+        return;
+    }
+
+    // Rayleigh-Ritz on span[W, P] for the smallest eigenpairs of M^-1 K:
+    // (Z^T K Z) y = theta (Z^T M Z) y, and the new W = Z * y of the smallest theta
+    if (recycleVectors_ > 0 && k + stored > 0) {
+        MatrixXd Z(n, k + stored), KZ(n, k + stored);
+        if (k > 0) {
+            Z.leftCols(k) = W_;
+            KZ.leftCols(k) = KW;
+        }
+        Z.rightCols(stored) = P.leftCols(stored);
+        KZ.rightCols(stored) = KP.leftCols(stored);
+        MatrixXd A = Z.transpose() * KZ;
+        A = (A + A.transpose()) / 2;
+        MatrixXd B = Z.transpose() * (invDiag.cwiseInverse().asDiagonal() * Z);
+        GeneralizedSelfAdjointEigenSolver<MatrixXd> es(A, B);
+        if (es.info() == Success) {
+            int keep = std::min(recycleVectors_, (int)Z.cols());
+            W_ = Z * es.eigenvectors().leftCols(keep);
+            for (int j = 0; j < keep; j++)
+                W_.col(j).normalize();
+        }
+    }
+}
+
+int StiffnessSolver::coldCG_(const SparseMatrix<double> & K, const VectorXd & F, const VectorXd & invDiag, const double & threshold) const
+{
+    int n = (int)F.size();
+    VectorXd r = F;
+    VectorXd z = invDiag.cwiseProduct(r);
+    VectorXd p = z;
+    VectorXd Kp(n);
+    double rz = r.dot(z);
+    int count = 0;
+    while (count < 10 * n && r.squaredNorm() >= threshold) {
+        Kp.noalias() = K * p;
+        r -= (rz / p.dot(Kp)) * Kp;
+        count++;
+        z = invDiag.cwiseProduct(r);
+        double rzNew = r.dot(z);
+        p = z + (rzNew / rz) * p;
+        rz = rzNew;
+    }
+    return count;
+}
@@ -0,0 +1,332 @@
+/**
+ * @file StiffnessSolver.h
+ * Solver wrapper for the repeated K U = F systems of the nonlinear scheme.
+ */
+
+#ifndef StiffnessSolver_h
+#define StiffnessSolver_h
+
+#include "Eigen/Eigen"
+#include "SkylineLDLT.h"
+#include "Mesh.h"
+#include <iostream>
+#include <string>
+
+using namespace Eigen;
+
+/* Solver for the global stiffness system that can be called repeatedly with
+ * the same sparsity pattern.
+ *
+ * In the nonlinear scheme the global stiffness matrix changes only through the
+ * stress-dependent moduli between two iterations, while the sparsity pattern
+ * never changes. Three modes are provided:
+ *
+ * 1. "direct": factorize K with SimplicialLDLT at every call (the original
+ * behavior). The symbolic analysis (AMD ordering and elimination tree) is done
+ * only once and reused as long as the pattern is the same.
+ *
+ * 2. "pcg": keep the last factorization and solve the updated system by the
+ * preconditioned conjugate gradient method, using the stale factor as the
+ * preconditioner and the last solution as the initial guess. The system is
+ * refactorized only when the PCG iteration count passes the threshold. On the
+ * late iterations of an increment, a factorization is then replaced by a
+ * handful of triangular solves.
+ *
+ * 3. "cg": Jacobi-preconditioned conjugate gradient without any factorization,
+ * warm-started from the last solution. The systems of consecutive nonlinear
+ * iterations and load increments are closely related, so the approximate
+ * low-eigenmode subspace found in one solve (Ritz vectors harvested from its
+ * search directions) is recycled to deflate the next solve (deflated CG,
+ * Saad et al. 2000). The iteration counts of the first and the last solve
+ * are reported, with the iteration count of cold starts (plain Jacobi CG
+ * from a zero guess, measured at each subspace rebuild) as the baseline of
+ * the savings. A solve that does not reach the tolerance in 10 n iterations
+ * falls back to a factorization.
+ *
+ * The factorization used by the direct and pcg modes is either the general
+ * SimplicialLDLT with AMD ordering, or the SkylineLDLT with RCM ordering which
+ * is faster when the profile of K is narrow (meshes numbered column by column).
+ * The default is the simplicial factorization. In "auto" the skyline is chosen
+ * at the first factorization if its profile is not larger than the fill of the
+ * AMD factor times a ratio (1 by default, so the skyline never stores more than
+ * the general factor); only the chosen one is factorized. The skyline
+ * refactorizes only the part of the factor affected by the changed entries.
+ */
+class StiffnessSolver
+{
+  public:
+    /** Available solving modes. */
+    enum Mode { DIRECT = 0, STALE_PCG = 1, DEFLATED_CG = 2 };
+
+    /** Available factorizations. */
+    enum Factorization { SIMPLICIAL = 0, SKYLINE = 1, AUTO = 2 };
+
+    /**
+     * Default constructor, direct mode.
+     */
+    StiffnessSolver();
+
+    /**
+     * Custom constructor.
+     *
+     * @param mode The solving mode, "direct", "pcg" or "cg".
+     * @param refactorIterations The PCG iteration count above which the matrix is refactorized.
+     * @param tolerance The relative residual tolerance of the PCG/CG iterations.
+     * @param recycleVectors The number of deflation vectors carried between CG solves.
+     * @param factorization The factorization, "simplicial", "skyline" or "auto".
+     * @param skylineRatio The profile-to-AMD-fill ratio below which "auto" chooses the skyline.
+     */
+    StiffnessSolver(std::string const & mode, const int & refactorIterations, const double & tolerance, const int & recycleVectors,
+                    std::string const & factorization, const double & skylineRatio);
+
+    /**
+     * Custom constructor from the solver settings of the input file ("solver",
+     * "refactor_iterations", "pcg_tolerance", "recycle_vectors",
+     * "factorization", "skyline_ratio").
+     *
+     * @param mesh The mesh with the settings.
+     */
+    StiffnessSolver(Mesh const & mesh);
+
+    /**
+     * Copy constructor. Only the settings and the streams are copied, the new
+     * solver starts without analysis, factorization, subspace or statistics.
+     *
+     * @param other The solver whose settings are used.
+     */
+    StiffnessSolver(const StiffnessSolver & other);
+
+    ~StiffnessSolver();
+
+    /**
+     * Solve K U = F.
+     *
+     * @param K The global stiffness matrix.
+     * @param F The global force vector.
+     * @param U The nodal displacement. On entry it is the initial guess for
+     * the iterative mode; on exit it is the solution.
+     */
+    void solve(const SparseMatrix<double> & K, const VectorXd & F, VectorXd & U);
+
+    /**
+     * Discard the stored factorization so the next call refactorizes.
+     */
+    void reset();
+
+    /**
+     * Set the streams of the messages, std::cout and std::cerr by default.
+     *
+     * @param out The stream of the progress messages (the factorization choice).
+     * @param err The stream of the warnings.
+     */
+    void setStreams(std::ostream & out, std::ostream & err);
+
+    /**
+     * Hold the factorization: while held, the direct and pcg modes solve with
+     * the stored factorization whenever K has its pattern, so repeated solves
+     * with one K (e.g. with changing loads) cost a single factorization. Call
+     * reset() before holding if K has changed. The cg mode is not affected.
+     *
+     * @param held Whether the factorization is held.
+     */
+    void hold(const bool & held);
+
+    /**
+     * Get the solving mode.
+     *
+     * @return The mode.
+     */
+    const Mode & mode() const;
+
+    /**
+     * Get the number of numerical factorizations done so far.
+     *
+     * @return The factorization count.
+     */
+    const int & factorizations() const;
+
+    /**
+     * Get the wall time of the (symbolic and) numerical factorizations done so far.
+     *
+     * @return The total time in ms.
+     */
+    const double & factorTime() const;
+
+    /**
+     * Get the number of PCG/CG iterations done so far.
+     *
+     * @return The total iteration count.
+     */
+    const int & iterations() const;
+
+    /**
+     * Get the number of CG solves done so far.
+     *
+     * @return The solve count.
+     */
+    const int & solves() const;
+
+    /**
+     * Get the number of CG iterations of the first solve.
+     *
+     * @return The iteration count, 0 before the first solve.
+     */
+    const int & firstIterations() const;
+
+    /**
+     * Get the number of CG iterations of the last solve.
+     *
+     * @return The iteration count, 0 before the first solve.
+     */
+    const int & lastIterations() const;
+
+    /**
+     * Get the cold-start equivalent of the CG solves done so far. Whenever the
+     * deflation subspace is (re)built (first solve, or after a fallback), the
+     * same system is also solved by the plain Jacobi CG from a zero initial
+     * guess without deflation, and its iteration count stands for every solve
+     * until the next rebuild. The saving of the recycling and warm start is
+     * this count minus iterations(). The reference costs one extra CG solve
+     * per rebuild.
+     *
+     * @return The cold-start iteration count.
+     */
+    const int & coldIterations() const;
+
+    /**
+     * Check if the skyline factorization is in use (partial refactorization).
+     *
+     * @return True if the skyline is in use.
+     */
+    const bool & skyline() const;
+
+    /**
+     * Get the fraction of the factor recomputed by the last factorization.
+     *
+     * @return The fraction, 1 for a full factorization.
+     */
+    double recomputedFraction() const;
+
+    /**
+     * Get the average fraction of the factor recomputed per factorization.
+     *
+     * @return The average fraction.
+     */
+    double averageRecomputedFraction() const;
+
+  private:
+    /** The solving mode */
+    Mode mode_;
+
+    /** PCG iteration count threshold for refactorization */
+    int refactorIterations_;
+
+    /** Relative residual tolerance of PCG */
+    double tolerance_;
+
+    /** The requested factorization */
+    Factorization factorization_;
+
+    /** Profile-to-fill ratio for the automatic choice */
+    double skylineRatio_;
+
+    /** The (possibly stale) factorization */
+    SimplicialLDLT<SparseMatrix<double> > factor_;
+
+    /** The (possibly stale) skyline factorization */
+    SkylineLDLT skyline_;
+
+    /** Whether the skyline factorization is the one in use */
+    bool useSkyline_;
+
+    /** Whether the symbolic analysis is available */
+    bool analyzed_;
+
+    /** Whether the numerical factorization is available */
+    bool factorized_;
+
+    /** Whether the factorization is held for repeated solves */
+    bool held_;
+
+    /** Cached sparsity pattern of the analyzed matrix */
+    VectorXi outerIndex_, innerIndex_;
+
+    /** Number of deflation vectors to recycle */
+    int recycleVectors_;
+
+    /** The recycled deflation subspace, n-by-k */
+    MatrixXd W_;
+
+    /** The streams of the progress messages and of the warnings */
+    std::ostream* out_;
+    std::ostream* err_;
+
+    /** Statistics */
+    int factorizations_;
+    int iterations_;
+    int solves_;
+    int firstIterations_;
+    int lastIterations_;
+    int coldReference_; /* iterations of the cold-start reference solve at the last subspace rebuild */
+    int coldIterations_; /* the reference summed over the CG solves */
+    double recomputedSum_;
+    double factorTime_;
+
+    /**
+     * Private helper function for the (symbolic and) numerical factorization.
+     *
+     * @param K The matrix to be factorized.
+     */
+    void factorize_(const SparseMatrix<double> & K);
+
+    /**
+     * Private helper function for solving with the factorization in use.
+     *
+     * @param b The right-hand side.
+     * @return The solution.
+     */
+    VectorXd factorSolve_(const VectorXd & b) const;
+
+    /**
+     * Private helper function for checking if K has the cached pattern.
+     *
+     * @param K The matrix to be checked.
+     * @return True if the pattern is the same as the analyzed one.
+     */
+    bool samePattern_(const SparseMatrix<double> & K) const;
+
+    /**
+     * Private helper function for the PCG iterations with the stale factor.
+     *
+     * @param K The current stiffness matrix.
+     * @param F The force vector.
+     * @param U The initial guess on entry and the solution on exit.
+     * @return True if converged within the threshold.
+     */
+    bool pcg_(const SparseMatrix<double> & K, const VectorXd & F, VectorXd & U);
+
+    /**
+     * Private helper function for the deflated CG iterations with subspace
+     * recycling. The deflation subspace is updated at exit. If the residual
+     * does not reach the tolerance, the system is solved by factorization.
+     *
+     * @param K The current stiffness matrix.
+     * @param F The force vector.
+     * @param U The initial guess on entry and the solution on exit.
+     */
+    void deflatedCG_(const SparseMatrix<double> & K, const VectorXd & F, VectorXd & U);
+
+    /**
+     * Private helper function for the cold-start reference: the Jacobi CG
+     * from a zero initial guess without deflation.
+     *
+     * @param K The current stiffness matrix.
+     * @param F The force vector.
+     * @param invDiag The inverse of the diagonal of K.
+     * @param threshold The squared residual norm to reach.
+     * @return The iteration count.
+     */
+    int coldCG_(const SparseMatrix<double> & K, const VectorXd & F, const VectorXd & invDiag, const double & threshold) const;
+};
+
+#endif /* StiffnessSolver_h */
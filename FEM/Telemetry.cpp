@@ -0,0 +1,76 @@
+/**
+ * @file Telemetry.cpp
+ * Implementation of Telemetry class.
+ */
+
+#include "Telemetry.h"
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+Telemetry::Telemetry(std::string const & fileName)
+  : enabled_(false), csv_(false), err_(&std::cerr)
+{
+    setFileName(fileName);
+}
+
+Telemetry::~Telemetry()
+{
+}
+
+void Telemetry::setFileName(std::string const & fileName)
+{
+    fileName_ = fileName;
+    enabled_ = !fileName.empty();
+    csv_ = fileName.size() >= 4 && fileName.compare(fileName.size() - 4, 4, ".csv") == 0;
+}
+
+void Telemetry::setStream(std::ostream & err)
+{
+    err_ = &err;
+}
+
+const bool & Telemetry::enabled() const
+{
+    return enabled_;
+}
+
+const std::string & Telemetry::fileName() const
+{
+    return fileName_;
+}
+
+void Telemetry::write(const Record & record)
+{
+    if (!enabled_)
+        return;
+    if (!file_.is_open()) {
+        file_.open(fileName_.c_str(), std::ios::trunc);
+        if (!file_) {
+            *err_ << "WARNING: Cannot write telemetry " << fileName_ << ", telemetry is disabled." << std::endl;
+            enabled_ = false;
+            return;
+        }
+        if (csv_)
+            file_ << "stage,increment,iteration,load_factor,error_ratio,max_change,max_element,max_point,unconverged,assembly_ms,factor_ms,solve_ms,update_ms" << std::endl;
+    }
+    if (csv_)
+        file_ << record.stage << "," << record.increment << "," << record.iteration << "," << record.loadFactor << ","
+              << record.errorRatio << "," << record.maxChange << "," << record.maxElement << "," << record.maxPoint << ","
+              << record.unconverged << "," << record.assembly << "," << record.factor << "," << record.solve << "," << record.update << std::endl;
+    else
+        file_ << "{\"stage\":\"" << record.stage << "\",\"increment\":" << record.increment << ",\"iteration\":" << record.iteration
+              << ",\"load_factor\":" << json_(record.loadFactor) << ",\"error_ratio\":" << json_(record.errorRatio) << ",\"max_change\":" << json_(record.maxChange)
+              << ",\"max_element\":" << record.maxElement << ",\"max_point\":" << record.maxPoint << ",\"unconverged\":" << record.unconverged
+              << ",\"assembly_ms\":" << json_(record.assembly) << ",\"factor_ms\":" << json_(record.factor) << ",\"solve_ms\":" << json_(record.solve)
+              << ",\"update_ms\":" << json_(record.update) << "}" << std::endl;
+}
+
+std::string Telemetry::json_(const double & value)
+{
+    if (!std::isfinite(value))
+        return "null"; // JSON has no nan or inf, e.g. the error ratio of a diverging iteration
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
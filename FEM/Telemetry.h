@@ -0,0 +1,105 @@
+/**
+ * @file Telemetry.h
+ * Per-iteration convergence telemetry of the nonlinear scheme.
+ */
+
+#ifndef Telemetry_h
+#define Telemetry_h
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/* Stream of one record per modulus iteration, as JSON lines or, for a file
+ * name ending in ".csv", as CSV with a header row. The file is only opened at
+ * the first record, so a disabled stream (empty file name) costs one branch
+ * per iteration and never touches the file system. Each record is flushed,
+ * so the stream can be followed while the analysis runs.
+ */
+class Telemetry
+{
+  public:
+    /** One modulus iteration. */
+    struct Record {
+        std::string stage; /* "body" or "traffic" */
+        int increment; /* increment No. (1-based) */
+        int iteration; /* iteration No. in the increment (1-based) */
+        double loadFactor; /* load factor of the increment */
+        double errorRatio; /* sumError / sumModulus, or |R| / |F| for the Newton scheme */
+        double maxChange; /* largest relative modulus change |M_new - M_old| / M_old */
+        int maxElement; /* element of the largest change, -1 if not available */
+        int maxPoint; /* Gaussian point of the largest change, -1 if not available */
+        int unconverged; /* Gaussian points whose damped modulus is off the target by more than 5% */
+        double assembly, factor, solve, update; /* wall times in ms */
+    };
+
+    /**
+     * Custom constructor.
+     *
+     * @param fileName The output file, empty to disable.
+     */
+    explicit Telemetry(std::string const & fileName);
+
+    ~Telemetry();
+
+    /**
+     * Change the output file before the first record.
+     *
+     * @param fileName The output file, empty to disable.
+     */
+    void setFileName(std::string const & fileName);
+
+    /**
+     * Set the stream of the warnings, std::cerr by default.
+     *
+     * @param err The stream.
+     */
+    void setStream(std::ostream & err);
+
+    /**
+     * Check if the stream is enabled.
+     *
+     * @return True if records are written.
+     */
+    const bool & enabled() const;
+
+    /**
+     * Get the output file name.
+     *
+     * @return The file name, empty if disabled.
+     */
+    const std::string & fileName() const;
+
+    /**
+     * Write a record.
+     *
+     * @param record The record.
+     */
+    void write(const Record & record);
+
+  private:
+    /** The output file name */
+    std::string fileName_;
+
+    /** Whether records are written */
+    bool enabled_;
+
+    /** Whether the format is CSV instead of JSON lines */
+    bool csv_;
+
+    /** The output stream, opened at the first record */
+    std::ofstream file_;
+
+    /** The stream of the warnings */
+    std::ostream* err_;
+
+    /**
+     * Private helper function to format a JSON number.
+     *
+     * @param value The value.
+     * @return The value as by operator<<, or null if it is not finite.
+     */
+    static std::string json_(const double & value);
+};
+
+#endif /* Telemetry_h */
@@ -7,42 +7,39 @@
  */
 
 #include "ViscoElastic.h"
+#include <cmath>
+#include <iostream>
 
-ViscoElastic::ViscoElastic(const bool & anisotropy, const bool & nonlinearity, const bool & noTension, const bool & geosynthetic, const std::vector<double> & properties)
-  : Material(anisotropy, nonlinearity, noTension, geosynthetic)
+ViscoElastic::ViscoElastic(const bool & anisotropy, const bool & nonlinearity, const bool & noTension, const bool & geosynthetic, const std::vector<double> & properties, const std::vector<double> & prony)
+  : Material(anisotropy, nonlinearity, noTension, geosynthetic), prony_(prony)
 {
+    if (anisotropy) {
+        std::cerr << "WARNING: Viscoelastic materials are isotropic, the anisotropy flag is ignored." << std::endl;
+        this->anisotropy = false;
+    }
     int i = 0;
 
-    // Isotropic: Modulus, Poisson's ratio, body force (r,z), thermal coefficient, temperature change
+    // Isotropic: instantaneous bulk & shear moduli, body force (r,z), thermal coefficient, temperature change
     double K0 = properties[i++];
     double G0 = properties[i++];
-    double t = properties[i++];
-
-    double e = 2.718281828;
-
-    // All the following are the temporary values.
-    // G_array and K_array are supposed to be the same length.
-    double G_array[] = {0.362,0.363,0.177,0.074,0.017,0.006};
-    std::vector<double> G (G_array, G_array + sizeof(G_array) / sizeof(double) );
-    double K_array[] = {0.362,0.363,0.177,0.074,0.017,0.006};
-    std::vector<double> K (K_array, K_array + sizeof(K_array) / sizeof(double) );
-    double tao_array[] = {4.09*0.000001,2.56*0.0001,7.71*0.001,2.1*0.1,3.88,6.53*10};
-    std::vector<double> tao (tao_array, tao_array + sizeof(tao_array) / sizeof(double) );
-
-    double Gt = G0;
-    double Kt = K0;
-    for (int j = 0; j < G.size(); j++){
-        Gt -= G0*G[j]*(1 - std::pow(e, -t/tao[j]));
-        Kt -= K0*K[j]*(1 - std::pow(e, -t/tao[j]));
+
+    // Prony terms as (g_j, k_j, tau_j) triplets
+    Kinf_ = K0;
+    Ginf_ = G0;
+    for (unsigned j = 0; j + 2 < prony.size(); j += 3) {
+        Gj_.push_back(G0 * prony[j]);
+        Kj_.push_back(K0 * prony[j + 1]);
+        tau_.push_back(prony[j + 2]);
+        Ginf_ -= Gj_.back();
+        Kinf_ -= Kj_.back();
+        Cj_.push_back(isotropicMatrix_(Kj_.back(), Gj_.back()));
     }
-    M_ = 9*Kt*Gt/(3*Kt + Gt);
-    v_ = (3*Kt - 2*Gt)/(6*Kt + 2*Gt);
-    // Compute the stress-strain constitutive matrix
-    E_ << 1 - v_, v_, v_, 0,
-          v_, 1 - v_, v_, 0,
-          v_, v_, 1 - v_, 0,
-          0,  0,   0,  (1-2*v_)/2;
-    E_ = E_ * M_ / (1+v_) /(1-2*v_);
+    if (Ginf_ < 0 || Kinf_ < 0)
+        std::cerr << "WARNING: The Prony terms of a viscoelastic material sum to more than 1, the long-term modulus is negative." << std::endl;
+    Cinf_ = isotropicMatrix_(Kinf_, Ginf_);
+
+    // The instantaneous response until a time step is set
+    setTimeStep(0);
 
     // Assign body force (unit weight)
     bodyForce_ << properties[i], properties[i+1];
@@ -58,3 +55,56 @@ ViscoElastic::ViscoElastic(const bool & anisotropy, const bool & nonlinearity, c
 ViscoElastic::~ViscoElastic()
 {
 }
+
+std::vector<double> ViscoElastic::parameters() const
+{
+    std::vector<double> list = Material::parameters();
+    list.insert(list.end(), prony_.begin(), prony_.end());
+    return list;
+}
+
+int ViscoElastic::terms() const
+{
+    return (int)tau_.size();
+}
+
+void ViscoElastic::setTimeStep(const double & dt)
+{
+    decay_.resize(tau_.size());
+    weight_.resize(tau_.size());
+    double K = Kinf_, G = Ginf_;
+    for (unsigned j = 0; j < tau_.size(); j++) {
+        double x = dt > 0 ? dt / tau_[j] : 0;
+        decay_[j] = std::exp(-x);
+        weight_[j] = x > 1e-8 ? -std::expm1(-x) / x : 1 - x / 2;
+        K += weight_[j] * Kj_[j];
+        G += weight_[j] * Gj_[j];
+    }
+    M_ = 9 * K * G / (3 * K + G);
+    v_ = (3 * K - 2 * G) / (6 * K + 2 * G);
+    E_ = isotropicMatrix_(K, G);
+}
+
+VectorXd ViscoElastic::historyStress(const VectorXd & strain, const MatrixXd & history) const
+{
+    VectorXd stress = (Cinf_ - E_) * strain;
+    for (unsigned j = 0; j < tau_.size(); j++)
+        stress += decay_[j] * history.col(j);
+    return stress;
+}
+
+void ViscoElastic::updateHistory(const VectorXd & strainIncrement, MatrixXd & history) const
+{
+    for (unsigned j = 0; j < tau_.size(); j++)
+        history.col(j) = decay_[j] * history.col(j) + weight_[j] * (Cj_[j] * strainIncrement);
+}
+
+MatrixXd ViscoElastic::isotropicMatrix_(const double & K, const double & G)
+{
+    MatrixXd C = MatrixXd::Zero(4, 4);
+    for (int r = 0; r < 3; r++)
+        for (int c = 0; c < 3; c++)
+            C(r, c) = r == c ? K + 4 * G / 3 : K - 2 * G / 3;
+    C(3, 3) = G;
+    return C;
+}
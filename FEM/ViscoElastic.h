@@ -4,6 +4,7 @@
  *
  * @author Jiayi Luo
  * @date May 19, 2018
+ * @note Prony-series relaxation with recursive internal variables on October 18, 2026.
  */
 
 #ifndef ViscoElastic_h
@@ -11,12 +12,100 @@
 
 #include "Material.h"
 
+/* Isotropic linear viscoelastic material (generalized Maxwell model). The
+ * shear and bulk relaxation moduli are Prony series with common relaxation
+ * times tau_j,
+ *
+ *   G(t) = G0 (1 - sum g_j (1 - exp(-t / tau_j))),
+ *   K(t) = K0 (1 - sum k_j (1 - exp(-t / tau_j))),
+ *
+ * i.e. a long-term part C_inf = C(K0 (1 - sum k_j), G0 (1 - sum g_j)) and one
+ * Maxwell branch C_j = C(k_j K0, g_j G0) per term, where C(K, G) is the
+ * isotropic constitutive matrix. Over a step dt with linear strain in time,
+ * the stress of branch j follows the recursion
+ *
+ *   h_j(t + dt) = a_j h_j(t) + w_j C_j (e(t + dt) - e(t)),
+ *   a_j = exp(-dt / tau_j), w_j = (1 - a_j) / (dt / tau_j),
+ *
+ * so a Gaussian point stores its strain and one stress per branch whatever
+ * the number of steps, and the stress is sigma = C_inf e + sum h_j. The E
+ * matrix of the material is the effective one of the current step,
+ * C_eff = C_inf + sum w_j C_j (C0 at dt = 0), and
+ * sigma(t + dt) = C_eff e(t + dt) + sigma*, with the history stress
+ * sigma* = (C_inf - C_eff) e(t) + sum a_j h_j(t).
+ */
 class ViscoElastic : public Material
 {
   public:
-    /** See the documentation of base class Material. */
-    ViscoElastic(const bool & anisotropy, const bool & nonlinearity, const bool & noTension, const bool & geosynthetic, const std::vector<double> & properties);
+    /**
+     * Custom constructor.
+     *
+     * @param properties Instantaneous bulk modulus K0, instantaneous shear modulus G0, body force (r,z), thermal coefficient, temperature change.
+     * @param prony The Prony terms as g_j, k_j, tau_j triplets.
+     * @see Material for the other parameters.
+     */
+    ViscoElastic(const bool & anisotropy, const bool & nonlinearity, const bool & noTension, const bool & geosynthetic, const std::vector<double> & properties, const std::vector<double> & prony);
     ~ViscoElastic();
+
+    std::vector<double> parameters() const;
+
+    /**
+     * Get the number of Prony terms.
+     *
+     * @return The number of terms.
+     */
+    int terms() const;
+
+    /**
+     * Set the time step, which sets the effective E matrix and the recursion
+     * coefficients of the step.
+     *
+     * @param dt The time step, 0 for the instantaneous response.
+     */
+    void setTimeStep(const double & dt);
+
+    /**
+     * Get the history stress sigma* of the current step at a Gaussian point.
+     *
+     * @param strain The mechanical strain at the start of the step.
+     * @param history The 4-by-terms branch stresses at the start of the step.
+     * @return The history stress.
+     */
+    VectorXd historyStress(const VectorXd & strain, const MatrixXd & history) const;
+
+    /**
+     * Advance the branch stresses of a Gaussian point over the current step.
+     *
+     * @param strainIncrement The mechanical strain increment of the step.
+     * @param history The 4-by-terms branch stresses, updated in place.
+     */
+    void updateHistory(const VectorXd & strainIncrement, MatrixXd & history) const;
+
+  private:
+    /** Long-term bulk & shear moduli */
+    double Kinf_, Ginf_;
+
+    /** Prony terms: relaxation time and the bulk & shear moduli of each branch */
+    std::vector<double> tau_, Kj_, Gj_;
+
+    /** Long-term and branch constitutive matrices */
+    MatrixXd Cinf_;
+    std::vector<MatrixXd> Cj_;
+
+    /** Recursion coefficients a_j and w_j of the current step */
+    std::vector<double> decay_, weight_;
+
+    /** The input Prony terms */
+    std::vector<double> prony_;
+
+    /**
+     * Private helper function for the isotropic constitutive matrix.
+     *
+     * @param K The bulk modulus.
+     * @param G The shear modulus.
+     * @return The 4-by-4 matrix.
+     */
+    static MatrixXd isotropicMatrix_(const double & K, const double & G);
 };
 
 #endif /* ViscoElastic_h */
@@ -0,0 +1,195 @@
+/**
+ * @file WarmStart.cpp
+ * Implementation of WarmStart class.
+ */
+
+#include "WarmStart.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+static const char tag[8] = {'F', 'E', 'M', 'W', 'A', 'R', 'M', '2'};
+
+template <typename T>
+static void writeValue(std::ofstream & out, const T & value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(std::ifstream & in, T & value)
+{
+    return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+WarmStart::WarmStart(Mesh & mesh, std::string const & directory, const int & maxRecords, const double & maxDistance)
+  : mesh_(mesh), maxRecords_(maxRecords > 1 ? maxRecords : 1), maxDistance_(maxDistance), coldIterations_(0), distance_(-1), err_(&std::cerr)
+{
+    std::ostringstream name;
+    name << directory;
+    if (!directory.empty() && directory[directory.size() - 1] != '/')
+        name << '/';
+    name << std::hex << std::setw(16) << std::setfill('0') << mesh.fingerprint() << ".warm";
+    fileName_ = name.str();
+}
+
+WarmStart::~WarmStart()
+{
+}
+
+void WarmStart::setStream(std::ostream & err)
+{
+    err_ = &err;
+}
+
+std::vector<double> WarmStart::features() const
+{
+    std::vector<double> list(mesh_.loadValue);
+    for (auto & edge : mesh_.edgeLoadValue)
+        list.insert(list.end(), edge.begin(), edge.end());
+    for (auto & m : mesh_.materialList) {
+        std::vector<double> parameters = m->parameters();
+        list.insert(list.end(), parameters.begin(), parameters.end());
+    }
+    return list;
+}
+
+bool WarmStart::seed(const std::vector<double> & features)
+{
+    std::vector<Record> records;
+    read_(records);
+    std::vector<int> models = models_();
+    int nearest = -1;
+    distance_ = -1;
+    for (int r = 0; r < (int)records.size(); r++) {
+        const std::vector<double> & stored = records[r].features;
+        if (records[r].models != models || stored.size() != features.size())
+            continue;
+        double sum = 0;
+        for (unsigned j = 0; j < features.size(); j++) {
+            double scale = std::abs(features[j]) + std::abs(stored[j]);
+            if (scale > 0)
+                sum += std::pow((features[j] - stored[j]) / scale, 2);
+        }
+        double d = features.empty() ? 0 : std::sqrt(sum / features.size());
+        if (nearest < 0 || d < distance_) {
+            nearest = r;
+            distance_ = d;
+        }
+    }
+    if (nearest < 0 || distance_ > maxDistance_)
+        return false;
+
+    for (int i = 0; i < mesh_.elementCount(); i++)
+        mesh_.elementArray()[i]->modulusAtGaussPt = records[nearest].modulus[i];
+    coldIterations_ = records[nearest].coldIterations;
+    return true;
+}
+
+void WarmStart::record(const std::vector<double> & features, const int & iterations)
+{
+    std::vector<Record> records;
+    read_(records);
+    Record current;
+    current.models = models_();
+    current.features = features;
+    current.coldIterations = coldIterations_ > 0 ? coldIterations_ : iterations; // a warm run keeps the cold reference
+    for (int i = 0; i < mesh_.elementCount(); i++)
+        current.modulus.push_back(mesh_.elementArray()[i]->modulusAtGaussPt);
+    records.push_back(current);
+    if ((int)records.size() > maxRecords_)
+        records.erase(records.begin(), records.end() - maxRecords_);
+
+    std::string tempName = fileName_ + ".tmp";
+    std::ofstream out(tempName.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        *err_ << "WARNING: Cannot write warm start store " << fileName_ << "." << std::endl;
+        return;
+    }
+    out.write(tag, sizeof(tag));
+    writeValue(out, mesh_.fingerprint());
+    writeValue(out, (std::int32_t)records.size());
+    for (auto & r : records) {
+        writeValue(out, (std::int32_t)r.models.size());
+        for (auto & m : r.models)
+            writeValue(out, (std::int32_t)m);
+        writeValue(out, (std::int32_t)r.features.size());
+        out.write(reinterpret_cast<const char*>(r.features.data()), r.features.size() * sizeof(double));
+        writeValue(out, (std::int32_t)r.coldIterations);
+        for (auto & modulus : r.modulus) {
+            writeValue(out, (std::int32_t)modulus.rows());
+            writeValue(out, (std::int32_t)modulus.cols());
+            out.write(reinterpret_cast<const char*>(modulus.data()), modulus.size() * sizeof(double));
+        }
+    }
+    out.close();
+    if (!out || std::rename(tempName.c_str(), fileName_.c_str()) != 0)
+        *err_ << "WARNING: Cannot write warm start store " << fileName_ << "." << std::endl;
+}
+
+const int & WarmStart::coldIterations() const
+{
+    return coldIterations_;
+}
+
+const double & WarmStart::distance() const
+{
+    return distance_;
+}
+
+void WarmStart::read_(std::vector<Record> & records) const
+{
+    records.clear();
+    std::ifstream in(fileName_.c_str(), std::ios::binary);
+    if (!in)
+        return; // no analysis of this mesh yet
+
+    char fileTag[sizeof(tag)];
+    std::uint64_t hash;
+    std::int32_t count;
+    bool ok = in.read(fileTag, sizeof(fileTag)) && std::memcmp(fileTag, tag, sizeof(tag)) == 0
+        && readValue(in, hash) && hash == mesh_.fingerprint() && readValue(in, count);
+    for (int r = 0; ok && r < count; r++) {
+        Record record;
+        std::int32_t modelCount, featureCount, cold;
+        ok = readValue(in, modelCount) && modelCount >= 0;
+        for (int m = 0; ok && m < modelCount; m++) {
+            std::int32_t model;
+            ok = readValue(in, model);
+            record.models.push_back(model);
+        }
+        ok = ok && readValue(in, featureCount) && featureCount >= 0;
+        if (ok) {
+            record.features.resize(featureCount);
+            ok = (bool)in.read(reinterpret_cast<char*>(record.features.data()), featureCount * sizeof(double)) && readValue(in, cold);
+        }
+        for (int i = 0; ok && i < mesh_.elementCount(); i++) {
+            const MatrixXd & current = mesh_.elementArray()[i]->modulusAtGaussPt;
+            std::int32_t rows, cols;
+            ok = readValue(in, rows) && readValue(in, cols) && rows == current.rows() && cols == current.cols();
+            if (ok) {
+                record.modulus.push_back(MatrixXd(rows, cols));
+                ok = (bool)in.read(reinterpret_cast<char*>(record.modulus.back().data()), record.modulus.back().size() * sizeof(double));
+            }
+        }
+        if (ok) {
+            record.coldIterations = cold;
+            records.push_back(record);
+        }
+    }
+    if (!ok)
+        *err_ << "WARNING: Warm start store " << fileName_ << " is damaged, " << records.size() << " records are used." << std::endl;
+}
+
+std::vector<int> WarmStart::models_() const
+{
+    std::vector<int> list;
+    for (auto & m : mesh_.materialList)
+        list.push_back(m->model());
+    return list;
+}
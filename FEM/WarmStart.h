@@ -0,0 +1,136 @@
+/**
+ * @file WarmStart.h
+ * Store of converged modulus fields for warm-starting nonlinear analyses.
+ */
+
+#ifndef WarmStart_h
+#define WarmStart_h
+
+#include "Mesh.h"
+#include "Eigen/Eigen"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Eigen;
+
+/* A store of converged Gauss-point modulus fields of one mesh, saved in the
+ * file <directory>/<fingerprint>.warm (see Mesh::fingerprint()). Each record
+ * holds the model No. of each material, the features of the analysis (the
+ * point and edge loads and the parameters of each material), the modulus
+ * field, and the iteration count of a cold start of the analysis it descends
+ * from.
+ *
+ * The nearest record is the one with the smallest root mean square of the
+ * relative feature differences |a - b| / (|a| + |b|); records with other
+ * material models or another number of features (a different load layout)
+ * are skipped, and a nearest record beyond the maximum distance is not used.
+ * The store keeps the latest records up to a limit, in the byte order of the
+ * machine that wrote it.
+ */
+class WarmStart
+{
+  public:
+    /**
+     * Custom constructor.
+     *
+     * @param mesh The mesh.
+     * @param directory The directory of the store files.
+     * @param maxRecords The number of records kept per mesh.
+     * @param maxDistance The largest feature distance of a seeding record.
+     */
+    WarmStart(Mesh & mesh, std::string const & directory, const int & maxRecords, const double & maxDistance);
+
+    ~WarmStart();
+
+    /**
+     * Set the stream of the warnings, std::cerr by default.
+     *
+     * @param err The stream.
+     */
+    void setStream(std::ostream & err);
+
+    /**
+     * Get the features of the current loads and materials. Call before the
+     * loads are scaled by the incremental scheme.
+     *
+     * @return The feature list.
+     */
+    std::vector<double> features() const;
+
+    /**
+     * Seed the Gauss-point moduli from the nearest record of the same
+     * material models, if it is within the maximum distance.
+     *
+     * @param features The features of the analysis.
+     * @return Whether a record was found and used.
+     */
+    bool seed(const std::vector<double> & features);
+
+    /**
+     * Add the current Gauss-point moduli as a record.
+     *
+     * @param features The features of the analysis.
+     * @param iterations The iterations of the analysis.
+     */
+    void record(const std::vector<double> & features, const int & iterations);
+
+    /**
+     * Get the cold-start iteration count of the seeding record.
+     *
+     * @return The iteration count, 0 if not seeded.
+     */
+    const int & coldIterations() const;
+
+    /**
+     * Get the feature distance of the nearest record, whether used or not.
+     *
+     * @return The distance, -1 if there is no comparable record.
+     */
+    const double & distance() const;
+
+  private:
+    /** A stored analysis */
+    struct Record
+    {
+        std::vector<int> models;
+        std::vector<double> features;
+        int coldIterations;
+        std::vector<MatrixXd> modulus;
+    };
+
+    /** The mesh */
+    Mesh & mesh_;
+
+    /** The store file of the mesh */
+    std::string fileName_;
+
+    /** Number of records kept */
+    int maxRecords_;
+
+    /** Largest feature distance of a seeding record */
+    double maxDistance_;
+
+    /** The seeding record */
+    int coldIterations_;
+    double distance_;
+
+    /** The stream of the warnings */
+    std::ostream* err_;
+
+    /**
+     * Private helper function to read the records of the store file.
+     *
+     * @param records The records whose moduli match the element sizes.
+     */
+    void read_(std::vector<Record> & records) const;
+
+    /**
+     * Private helper function to get the model No. of each material.
+     *
+     * @return The model list.
+     */
+    std::vector<int> models_() const;
+};
+
+#endif /* WarmStart_h */
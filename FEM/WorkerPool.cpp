@@ -0,0 +1,78 @@
+/**
+ * @file WorkerPool.cpp
+ * Implementation of WorkerPool class.
+ */
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool()
+  : task_(NULL), threads_(1), count_(0), generation_(0), pending_(0), stopping_(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop_();
+}
+
+void WorkerPool::run(const int & threads, const int & count, const std::function<void(int)> & task)
+{
+    if (threads <= 1 || count <= 1) {
+        for (int c = 0; c < count; c++)
+            task(c);
+        return;
+    }
+    if ((int)workers_.size() != threads - 1) {
+        stop_();
+        threads_ = threads;
+        for (int t = 1; t < threads; t++)
+            workers_.push_back(std::thread(&WorkerPool::work_, this, t, generation_));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        count_ = count;
+        pending_ = threads_ - 1;
+        generation_++;
+    }
+    start_.notify_all();
+    for (int c = 0; c < count; c += threads_)
+        task(c);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return pending_ == 0; });
+    task_ = NULL;
+}
+
+void WorkerPool::stop_()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_.notify_all();
+    for (auto & worker : workers_)
+        worker.join();
+    workers_.clear();
+    stopping_ = false;
+}
+
+void WorkerPool::work_(const int t, unsigned long generation)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        start_.wait(lock, [&]() { return stopping_ || generation_ != generation; });
+        if (stopping_)
+            return;
+        generation = generation_;
+        const std::function<void(int)> & task = *task_;
+        int count = count_, threads = threads_;
+        lock.unlock();
+        for (int c = t; c < count; c += threads)
+            task(c);
+        lock.lock();
+        if (--pending_ == 0)
+            done_.notify_one();
+    }
+}
@@ -0,0 +1,81 @@
+/**
+ * @file WorkerPool.h
+ * Persistent worker threads for the parallel sweeps of the nonlinear scheme.
+ */
+
+#ifndef WorkerPool_h
+#define WorkerPool_h
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Runs task(c) for c = 0, ..., count - 1 on a set of threads that is started
+ * once and lives as long as the pool. The calling thread takes part as thread
+ * 0, and task c goes to thread c % threads (static round-robin). A nonlinear
+ * iteration has 3-4 parallel sweeps, so starting and joining new threads at
+ * every sweep costs tens of microseconds per thread each time; the pool only
+ * wakes its waiting workers instead.
+ */
+class WorkerPool
+{
+  public:
+    WorkerPool();
+
+    /** Stops and joins the worker threads. */
+    ~WorkerPool();
+
+    /**
+     * Run the tasks and wait for all of them. The worker threads are started
+     * at the first call with more than one thread, and restarted only if the
+     * number of threads changes, so callers should pass a fixed number. A
+     * worker without a task (t >= count) just reports the end of the run.
+     *
+     * @param threads The number of threads, including the calling one.
+     * @param count The number of tasks.
+     * @param task The task, called with the task index. Concurrent tasks must write disjoint data.
+     */
+    void run(const int & threads, const int & count, const std::function<void(int)> & task);
+
+  private:
+    /** The worker threads 1, ..., threads - 1 */
+    std::vector<std::thread> workers_;
+
+    /** Guards all members below */
+    std::mutex mutex_;
+
+    /** Signals a new run (or stopping) to the workers, and the end of the last worker task to the caller */
+    std::condition_variable start_, done_;
+
+    /** The task of the current run */
+    const std::function<void(int)>* task_;
+
+    /** The number of threads and tasks of the current run */
+    int threads_, count_;
+
+    /** The number of the current run, so a worker runs each one once */
+    unsigned long generation_;
+
+    /** The workers that have not finished the current run */
+    int pending_;
+
+    /** Whether the workers are asked to exit */
+    bool stopping_;
+
+    /**
+     * Private helper function to stop and join the worker threads.
+     */
+    void stop_();
+
+    /**
+     * Private helper function run by each worker thread.
+     *
+     * @param t The thread index.
+     * @param generation The run number when the thread was started.
+     */
+    void work_(const int t, unsigned long generation);
+};
+
+#endif /* WorkerPool_h */
@@ -9,10 +9,14 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <sstream>
+#include <vector>
 #include <chrono>
 
 #include "Linear.h"
 #include "Nonlinear.h"
+#include "Creep.h"
+#include "FrequencyDomain.h"
 #include "BackAnalysis.h"
 // #include "IO.h" //#include "Matrix/src/Core/IO.h" // to change the folder name, you can just change in Node.h and Shape.h into "include Matrix/Eigen"
 
@@ -197,23 +201,55 @@ auto start = std::chrono::high_resolution_clock::now();
        // std::string outVTKName(argv[i]);
        // outVTKName.replace(outVTKName.begin()+outVTKName.rfind('.')+1, outVTKName.end(), "vtk");
 
-       Mesh mesh = Mesh(inFileName); // on stack, make sure lifetime of 'mesh' is longer than Analysis case
+       Mesh mesh(inFileName); // on stack, make sure lifetime of 'mesh' is longer than Analysis case
        Analysis* caseType; // 'case' is a reserved keyword for switch()
-	   if (mesh.nonlinear) {
+	   if (mesh.setting("dynamic", 0) != 0) {
+		   if (mesh.nonlinear)
+			   std::cerr << "WARNING: Nonlinear layers take their initial moduli in the dynamic analysis, the stress dependency is not iterated." << std::endl;
+		   std::cout << "> Frequency-domain dynamic analysis scheme" << std::endl;
+		   caseType = new FrequencyDomain(mesh);
+	   }
+	   else if (mesh.nonlinear) {
+		   if (mesh.viscoelastic)
+			   std::cerr << "WARNING: Viscoelastic layers take their instantaneous moduli in the nonlinear analysis." << std::endl;
 		   std::cout << "> Nonlinear analysis scheme" << std::endl;
 		   caseType = new Nonlinear(mesh);
 	   }
+	   else if (mesh.viscoelastic) {
+		   std::cout << "> Viscoelastic analysis scheme" << std::endl;
+		   caseType = new Creep(mesh);
+	   }
 	   else {
 		   std::cout << "> Linear analysis scheme" << std::endl;
 		   caseType = new Linear(mesh);
 	   }
 
+       // Several traffic load cases from one body force stage ("load_scales" setting)
+       std::string loadScales = mesh.settingString("load_scales", "");
+       if (mesh.nonlinear && !loadScales.empty() && mesh.setting("dynamic", 0) == 0) {
+           std::istringstream in(loadScales);
+           std::vector<double> scales;
+           double scale;
+           while (in >> scale)
+               scales.push_back(scale);
+           static_cast<Nonlinear*>(caseType)->solveScenarios(scales, inFile);
+           delete caseType; caseType = NULL;
+           continue;
+       }
+
        caseType->solve();
+       if (mesh.nonlinear && mesh.setting("dynamic", 0) == 0 && static_cast<Nonlinear*>(caseType)->hasFailed()) {
+           std::cerr << "ERROR: " << inFileName << " did not reach the full load, no output is written." << std::endl;
+           delete caseType; caseType = NULL;
+           continue;
+       }
        // caseType->printDisp();
        // caseType->printStrain();
        // caseType->printStress();
        // caseType->writeToFile(outFileName);
        caseType->writeToVTK(outVTKName);
+       if (mesh.setting("dynamic", 0) != 0)
+           static_cast<FrequencyDomain*>(caseType)->writeHistory(inFile + "_fwd.csv");
        delete caseType; caseType = NULL;
    }
 
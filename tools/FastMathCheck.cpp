@@ -0,0 +1,69 @@
+/**
+ * @file FastMathCheck.cpp
+ * Validation driver of FastMath.h: the error bounds documented there, measured
+ * against std::log, std::exp and std::pow, and the throughput of arrayPow().
+ *
+ * Not part of the FEM build. From the repository root:
+ *   g++ -O3 -std=c++11 -IFEM tools/FastMathCheck.cpp -o fastmath_check && ./fastmath_check [samples]
+ */
+
+#include "FastMath.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    long samples = argc > 1 ? std::atol(argv[1]) : 10000000; // 10^7 by default
+    std::mt19937_64 random(20260101); // fixed seed, so the bounds are reproducible
+    std::uniform_real_distribution<double> logX(std::log(1e-6), std::log(1e6)); // x in [1e-6, 1e6], log-uniform
+    std::uniform_real_distribution<double> exponent(-3, 3); // a in [-3, 3]
+    std::uniform_real_distribution<double> mantissa(1 / std::sqrt(2.0), std::sqrt(2.0));
+    std::uniform_real_distribution<double> argument(-708, 709);
+
+    double logNear = 0, logFar = 0, expError = 0, powError = 0;
+    for (long i = 0; i < samples; i++) {
+        // fastLog: absolute error near 1, where log(x) -> 0, and relative error elsewhere
+        double m = mantissa(random);
+        logNear = std::max(logNear, std::abs(fastLog(m) - std::log(m)));
+        double x = std::exp(logX(random));
+        double exact = std::log(x);
+        if (x < 1 / std::sqrt(2.0) || x >= std::sqrt(2.0))
+            logFar = std::max(logFar, std::abs(fastLog(x) - exact) / std::abs(exact));
+
+        double y = argument(random);
+        expError = std::max(expError, std::abs(fastExp(y) - std::exp(y)) / std::exp(y));
+
+        // fastPow: relative error scaled by the condition number 1 + |a log x| of exp(a log x)
+        double a = exponent(random);
+        double power = std::pow(x, a);
+        powError = std::max(powError, std::abs(fastPow(x, a) - power) / power / (1 + std::abs(a * exact)));
+    }
+    std::printf("samples: %ld\n", samples);
+    std::printf("fastLog: absolute error %.2e for x in [1/sqrt(2), sqrt(2)), relative error %.2e elsewhere\n", logNear, logFar);
+    std::printf("fastExp: relative error %.2e for y in [-708, 709]\n", expError);
+    std::printf("fastPow: relative error %.2e * (1 + |a log x|)\n", powError);
+
+    // Throughput of the batched power over arrays of the size of a modulus update block
+    const int n = 1024;
+    std::vector<double> base(n), result(n);
+    for (int j = 0; j < n; j++)
+        base[j] = std::exp(logX(random));
+    double seconds[2];
+    for (int fast = 0; fast < 2; fast++) {
+        auto start = std::chrono::steady_clock::now();
+        double sum = 0;
+        for (int r = 0; r < 20000; r++) {
+            arrayPow(n, base.data(), 0.5 + r * 1e-6, result.data(), fast != 0);
+            sum += result[r % n];
+        }
+        seconds[fast] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("arrayPow (%s): %.1f ns per value (checksum %g)\n", fast ? "fastPow" : "std::pow", 1e9 * seconds[fast] / (20000.0 * n), sum);
+    }
+    std::printf("speedup: %.2fx\n", seconds[0] / seconds[1]);
+    return 0;
+}